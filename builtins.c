@@ -0,0 +1,41 @@
+#include <string.h>
+#include "builtins.h"
+#include "json.h"
+#include "numeric.h"
+#include "parallel.h"
+#include "regex.h"
+#include "stream.h"
+
+typedef struct {
+    const char* name;
+    BuiltinFunction function;
+} Builtin;
+
+static const Builtin builtins[] = {
+    {"fopen", builtin_fopen},
+    {"fgets", builtin_fgets},
+    {"fwrite", builtin_fwrite},
+    {"fclose", builtin_fclose},
+    {"feof", builtin_feof},
+    {"file_get_contents", builtin_file_get_contents},
+    {"parallel_map", builtin_parallel_map},
+    {"parallel_reduce", builtin_parallel_reduce},
+    {"array_sum", builtin_array_sum},
+    {"max", builtin_max},
+    {"min", builtin_min},
+    {"preg_match", builtin_preg_match},
+    {"preg_match_all", builtin_preg_match_all},
+    {"preg_replace", builtin_preg_replace},
+    {"preg_split", builtin_preg_split},
+    {"json_encode", builtin_json_encode},
+    {"json_decode", builtin_json_decode},
+};
+
+BuiltinFunction builtin_lookup(const char* name) {
+    for (size_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]); i++) {
+        if (strcmp(builtins[i].name, name) == 0) {
+            return builtins[i].function;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,13 @@
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include "parser.h"
+
+// Les arguments sont des Variable : name est le nom de la variable passée
+// (NULL pour une valeur temporaire), array est emprunté. Le résultat
+// (value et/ou array) appartient à l'appelant.
+typedef int (*BuiltinFunction)(Parser* parser, int argc, Variable* args, Variable* result);
+
+BuiltinFunction builtin_lookup(const char* name);
+
+#endif
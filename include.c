@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "include.h"
+#include "utils.h"
+
+static CompiledFile** buckets = NULL;
+static int bucket_count = 0;
+static int file_count = 0;
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int hash_path(const char* path) {
+    unsigned int hash = 2166136261u;
+    while (*path) {
+        hash ^= (unsigned char)*path++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void grow_buckets(void) {
+    int new_count = bucket_count ? bucket_count * 2 : 64;
+    CompiledFile** new_buckets = calloc(new_count, sizeof(CompiledFile*));
+    for (int i = 0; i < bucket_count; i++) {
+        CompiledFile* file = buckets[i];
+        while (file) {
+            CompiledFile* next = file->next;
+            unsigned int index = hash_path(file->path) % new_count;
+            file->next = new_buckets[index];
+            new_buckets[index] = file;
+            file = next;
+        }
+    }
+    free(buckets);
+    buckets = new_buckets;
+    bucket_count = new_count;
+}
+
+static int compile_file(CompiledFile* file, const struct stat* st) {
+    char* source = read_file(file->path);
+    if (!source) {
+        return -1;
+    }
+    
+    if (file->lexer) {
+        lexer_reset(file->lexer, source);
+    } else {
+        file->lexer = lexer_create(source);
+    }
+    lexer_tokenize(file->lexer);
+    free(source);
+    
+    file->device = st->st_dev;
+    file->inode = st->st_ino;
+    file->mtime = st->st_mtime;
+    file->size = st->st_size;
+    return 0;
+}
+
+// Retourne le fichier compilé, à jour selon inode et mtime, ou NULL.
+CompiledFile* compiled_file_acquire(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return NULL;
+    }
+    
+    pthread_mutex_lock(&cache_mutex);
+    if (file_count >= bucket_count) {
+        grow_buckets();
+    }
+    
+    unsigned int index = hash_path(path) % bucket_count;
+    CompiledFile* file = buckets[index];
+    while (file && strcmp(file->path, path) != 0) {
+        file = file->next;
+    }
+    
+    if (!file) {
+        file = malloc(sizeof(CompiledFile));
+        file->path = strdup(path);
+        file->lexer = NULL;
+        file->active = 0;
+        if (compile_file(file, &st) != 0) {
+            free(file->path);
+            free(file);
+            pthread_mutex_unlock(&cache_mutex);
+            return NULL;
+        }
+        file->next = buckets[index];
+        buckets[index] = file;
+        file_count++;
+    } else if (file->active == 0 && 
+               (file->device != st.st_dev || file->inode != st.st_ino || 
+                file->mtime != st.st_mtime || file->size != st.st_size)) {
+        if (compile_file(file, &st) != 0) {
+            pthread_mutex_unlock(&cache_mutex);
+            return NULL;
+        }
+    }
+    
+    file->active++;
+    pthread_mutex_unlock(&cache_mutex);
+    return file;
+}
+
+void compiled_file_release(CompiledFile* file) {
+    pthread_mutex_lock(&cache_mutex);
+    file->active--;
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+void compiled_file_cache_clear(void) {
+    pthread_mutex_lock(&cache_mutex);
+    for (int i = 0; i < bucket_count; i++) {
+        CompiledFile* file = buckets[i];
+        while (file) {
+            CompiledFile* next = file->next;
+            lexer_free(file->lexer);
+            free(file->path);
+            free(file);
+            file = next;
+        }
+    }
+    free(buckets);
+    buckets = NULL;
+    bucket_count = 0;
+    file_count = 0;
+    pthread_mutex_unlock(&cache_mutex);
+}
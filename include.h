@@ -0,0 +1,24 @@
+#ifndef INCLUDE_H
+#define INCLUDE_H
+
+#include <sys/types.h>
+#include <time.h>
+#include "lexer.h"
+
+// Fichier inclus, tokenisé une seule fois par processus
+typedef struct CompiledFile {
+    char* path;
+    dev_t device;
+    ino_t inode;
+    time_t mtime;
+    off_t size;
+    Lexer* lexer;
+    int active;   // Exécutions en cours ; le fichier n'est pas recompilé tant que > 0
+    struct CompiledFile* next;
+} CompiledFile;
+
+CompiledFile* compiled_file_acquire(const char* path);
+void compiled_file_release(CompiledFile* file);
+void compiled_file_cache_clear(void);
+
+#endif
@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "interpreter.h"
+#include "utils.h"
+
+Interpreter* interpreter_create(void) {
+    Interpreter* interpreter = malloc(sizeof(Interpreter));
+    interpreter->lexer = lexer_create("");
+    lexer_tokenize(interpreter->lexer); // TOKEN_EOF : exécutable avant tout chargement
+    interpreter->parser = parser_create(interpreter->lexer);
+    interpreter->filename = NULL;
+    return interpreter;
+}
+
+void interpreter_free(Interpreter* interpreter) {
+    parser_free(interpreter->parser);
+    lexer_free(interpreter->lexer);
+    free(interpreter->filename);
+    free(interpreter);
+}
+
+int interpreter_load(Interpreter* interpreter, const char* source) {
+    lexer_reset(interpreter->lexer, source);
+    lexer_tokenize(interpreter->lexer);
+    interpreter->parser->position = 0;
+    free(interpreter->filename);
+    interpreter->filename = NULL;
+    interpreter->parser->filename = NULL;
+    return 0;
+}
+
+int interpreter_load_file(Interpreter* interpreter, const char* filename) {
+    char* source = read_file(filename);
+    if (!source) {
+        return -1;
+    }
+    interpreter_load(interpreter, source);
+    free(source);
+    interpreter->filename = strdup(filename);
+    interpreter->parser->filename = interpreter->filename;
+    return 0;
+}
+
+void interpreter_set_variable(Interpreter* interpreter, const char* name, const char* value) {
+    if (name[0] == '$') {
+        name++;
+    }
+    parser_set_variable(interpreter->parser, name, value);
+}
+
+// Retourne la taille totale de la sortie ; si elle est >= output_size,
+// la sortie a été tronquée. Avec output NULL, la sortie va sur stdout.
+size_t interpreter_run(Interpreter* interpreter, char* output, size_t output_size) {
+    Parser* parser = interpreter->parser;
+    parser_set_output(parser, output, output_size);
+    parser->position = 0;
+    parser->halted = 0;
+    parser_run(parser);
+    return parser->output_length;
+}
+
+int interpreter_halted(const Interpreter* interpreter) {
+    return interpreter->parser->halted;
+}
+
+void interpreter_reset(Interpreter* interpreter) {
+    parser_reset(interpreter->parser);
+}
@@ -0,0 +1,24 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <stddef.h>
+#include "lexer.h"
+#include "parser.h"
+
+// Contexte réutilisable pour embarquer l'interpréteur (libphpinterp)
+typedef struct {
+    Lexer* lexer;
+    Parser* parser;
+    char* filename;
+} Interpreter;
+
+Interpreter* interpreter_create(void);
+void interpreter_free(Interpreter* interpreter);
+int interpreter_load(Interpreter* interpreter, const char* source);
+int interpreter_load_file(Interpreter* interpreter, const char* filename);
+void interpreter_set_variable(Interpreter* interpreter, const char* name, const char* value);
+size_t interpreter_run(Interpreter* interpreter, char* output, size_t output_size);
+int interpreter_halted(const Interpreter* interpreter); // Erreur fatale pendant le dernier run
+void interpreter_reset(Interpreter* interpreter);
+
+#endif
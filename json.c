@@ -0,0 +1,540 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "json.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Taille de chaque octet une fois échappé : 1 (tel quel), 2 (\n, \") ou 6 (\u00XX)
+static const unsigned char escape_length[256] = {
+    6, 6, 6, 6, 6, 6, 6, 6, 2, 2, 2, 6, 2, 2, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
+static const char hex_digits[] = "0123456789abcdef";
+
+// Les valeurs de l'interpréteur sont des chaînes : celles qui respectent
+// la grammaire des nombres JSON sont écrites telles quelles.
+static int is_json_number(const char* s) {
+    if (*s == '-') s++;
+    if (*s == '0') {
+        s++;
+    } else if (*s >= '1' && *s <= '9') {
+        while (*s >= '0' && *s <= '9') s++;
+    } else {
+        return 0;
+    }
+    if (*s == '.') {
+        s++;
+        if (*s < '0' || *s > '9') return 0;
+        while (*s >= '0' && *s <= '9') s++;
+    }
+    if (*s == 'e' || *s == 'E') {
+        s++;
+        if (*s == '+' || *s == '-') s++;
+        if (*s < '0' || *s > '9') return 0;
+        while (*s >= '0' && *s <= '9') s++;
+    }
+    return *s == '\0';
+}
+
+static size_t string_size(const char* s) {
+    size_t size = 2;
+    for (const unsigned char* p = (const unsigned char*)s; *p; p++) {
+        size += escape_length[*p];
+    }
+    return size;
+}
+
+static size_t value_size(const char* value, int is_json) {
+    if (!value) {
+        return 4; // null
+    }
+    return is_json || is_json_number(value) ? strlen(value) : string_size(value);
+}
+
+static char* write_string(char* out, const char* s) {
+    const unsigned char* p = (const unsigned char*)s;
+    *out++ = '"';
+    while (*p) {
+        const unsigned char* run = p;
+        while (*p && escape_length[*p] == 1) {
+            p++;
+        }
+        memcpy(out, run, p - run);
+        out += p - run;
+        if (!*p) {
+            break;
+        }
+
+        *out++ = '\\';
+        switch (*p) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '\b': *out++ = 'b'; break;
+            case '\t': *out++ = 't'; break;
+            case '\n': *out++ = 'n'; break;
+            case '\f': *out++ = 'f'; break;
+            case '\r': *out++ = 'r'; break;
+            default:
+                *out++ = 'u';
+                *out++ = '0';
+                *out++ = '0';
+                *out++ = hex_digits[*p >> 4];
+                *out++ = hex_digits[*p & 15];
+                break;
+        }
+        p++;
+    }
+    *out++ = '"';
+    return out;
+}
+
+// is_json : objet ou tableau imbriqué issu de json_decode, réécrit tel quel
+static char* write_value(char* out, const char* value, int is_json) {
+    if (!value) {
+        memcpy(out, "null", 4);
+        return out + 4;
+    }
+    if (is_json || is_json_number(value)) {
+        size_t length = strlen(value);
+        memcpy(out, value, length);
+        return out + length;
+    }
+    return write_string(out, value);
+}
+
+// Taille exacte calculée d'abord, puis écriture directe dans un seul buffer
+static char* encode_array(const Array* array) {
+    int is_list = 1;
+    for (int i = 0; i < array->count; i++) {
+        if (array->items[i].key) {
+            is_list = 0;
+            break;
+        }
+    }
+
+    char index[16];
+    size_t size = 2 + (array->count > 0 ? array->count - 1 : 0);
+    for (int i = 0; i < array->count; i++) {
+        size += value_size(array->items[i].value, array->items[i].is_json);
+        if (!is_list) {
+            if (array->items[i].key) {
+                size += string_size(array->items[i].key) + 1;
+            } else {
+                size += snprintf(index, sizeof(index), "%d", i) + 3;
+            }
+        }
+    }
+
+    char* json = malloc(size + 1);
+    char* out = json;
+    *out++ = is_list ? '[' : '{';
+    for (int i = 0; i < array->count; i++) {
+        if (i > 0) {
+            *out++ = ',';
+        }
+        if (!is_list) {
+            if (array->items[i].key) {
+                out = write_string(out, array->items[i].key);
+            } else {
+                snprintf(index, sizeof(index), "%d", i);
+                out = write_string(out, index);
+            }
+            *out++ = ':';
+        }
+        out = write_value(out, array->items[i].value, array->items[i].is_json);
+    }
+    *out++ = is_list ? ']' : '}';
+    *out = '\0';
+    return json;
+}
+
+int builtin_json_encode(Parser* parser, int argc, Variable* args, Variable* result) {
+    (void)parser;
+    if (argc < 1) {
+        return -1;
+    }
+
+    if (args[0].array) {
+        result->value = encode_array(args[0].array);
+    } else {
+        result->value = malloc(value_size(args[0].value, 0) + 1);
+        *write_value(result->value, args[0].value, 0) = '\0';
+    }
+    return 0;
+}
+
+typedef struct {
+    const char* p;
+    const char* end;
+    int depth;
+} Decoder;
+
+static void skip_whitespace(Decoder* decoder) {
+    while (decoder->p < decoder->end &&
+           (*decoder->p == ' ' || *decoder->p == '\n' || *decoder->p == '\r' || *decoder->p == '\t')) {
+        decoder->p++;
+    }
+}
+
+// Prochain '"', '\\' ou caractère de contrôle, 16 octets à la fois avec SSE2
+static const char* scan_string(const char* p, const char* end) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+            _mm_cmpeq_epi8(_mm_max_epu8(block, control), control));
+        int mask = _mm_movemask_epi8(special);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20) {
+        p++;
+    }
+    return p;
+}
+
+static int hex_value(const char* p) {
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return -1;
+    }
+    return value;
+}
+
+static char* write_utf8(char* out, unsigned int code) {
+    if (code < 0x80) {
+        *out++ = code;
+    } else if (code < 0x800) {
+        *out++ = 0xC0 | (code >> 6);
+        *out++ = 0x80 | (code & 0x3F);
+    } else if (code < 0x10000) {
+        *out++ = 0xE0 | (code >> 12);
+        *out++ = 0x80 | ((code >> 6) & 0x3F);
+        *out++ = 0x80 | (code & 0x3F);
+    } else {
+        *out++ = 0xF0 | (code >> 18);
+        *out++ = 0x80 | ((code >> 12) & 0x3F);
+        *out++ = 0x80 | ((code >> 6) & 0x3F);
+        *out++ = 0x80 | (code & 0x3F);
+    }
+    return out;
+}
+
+// Décode une chaîne (après le '"' ouvrant) directement dans sa valeur
+// finale ; avec out NULL, la chaîne est seulement validée.
+static int decode_string(Decoder* decoder, char** out) {
+    const char* start = decoder->p;
+    char* value = NULL;
+    char* write = NULL;
+
+    while (1) {
+        const char* special = scan_string(decoder->p, decoder->end);
+        if (special >= decoder->end || (unsigned char)*special < 0x20) {
+            free(value);
+            return -1;
+        }
+        if (write) {
+            memcpy(write, decoder->p, special - decoder->p);
+            write += special - decoder->p;
+        }
+        decoder->p = special + 1;
+        if (*special == '"') {
+            break;
+        }
+
+        // Premier échappement : le résultat tient dans la taille brute restante
+        if (out && !value) {
+            const char* closing = special;
+            while (closing < decoder->end && *closing != '"') {
+                closing += *closing == '\\' ? 2 : 1;
+            }
+            value = malloc(closing - start + 1);
+            memcpy(value, start, special - start);
+            write = value + (special - start);
+        }
+        if (decoder->p >= decoder->end) {
+            free(value);
+            return -1;
+        }
+
+        char c = *decoder->p++;
+        char unescaped = 0;
+        switch (c) {
+            case '"': unescaped = '"'; break;
+            case '\\': unescaped = '\\'; break;
+            case '/': unescaped = '/'; break;
+            case 'b': unescaped = '\b'; break;
+            case 'f': unescaped = '\f'; break;
+            case 'n': unescaped = '\n'; break;
+            case 'r': unescaped = '\r'; break;
+            case 't': unescaped = '\t'; break;
+            case 'u': {
+                int code = decoder->end - decoder->p >= 4 ? hex_value(decoder->p) : -1;
+                if (code < 0) {
+                    free(value);
+                    return -1;
+                }
+                decoder->p += 4;
+                unsigned int codepoint = code;
+                if (code >= 0xD800 && code <= 0xDBFF && decoder->end - decoder->p >= 6 &&
+                    decoder->p[0] == '\\' && decoder->p[1] == 'u') {
+                    int low = hex_value(decoder->p + 2);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        codepoint = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        decoder->p += 6;
+                    }
+                }
+                if (write) {
+                    write = write_utf8(write, codepoint);
+                }
+                continue;
+            }
+            default:
+                free(value);
+                return -1;
+        }
+        if (write) {
+            *write++ = unescaped;
+        }
+    }
+
+    if (out) {
+        if (!value) {
+            size_t length = decoder->p - 1 - start;
+            value = malloc(length + 1);
+            memcpy(value, start, length);
+            write = value + length;
+        }
+        *write = '\0';
+        *out = value;
+    }
+    return 0;
+}
+
+static int decode_number(Decoder* decoder) {
+    const char* p = decoder->p;
+    const char* end = decoder->end;
+    if (p < end && *p == '-') p++;
+    if (p < end && *p == '0') {
+        p++;
+    } else if (p < end && *p >= '1' && *p <= '9') {
+        while (p < end && *p >= '0' && *p <= '9') p++;
+    } else {
+        return -1;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        if (p >= end || *p < '0' || *p > '9') return -1;
+        while (p < end && *p >= '0' && *p <= '9') p++;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        if (p < end && (*p == '+' || *p == '-')) p++;
+        if (p >= end || *p < '0' || *p > '9') return -1;
+        while (p < end && *p >= '0' && *p <= '9') p++;
+    }
+    decoder->p = p;
+    return 0;
+}
+
+static int match_literal(Decoder* decoder, const char* literal) {
+    size_t length = strlen(literal);
+    if ((size_t)(decoder->end - decoder->p) < length || memcmp(decoder->p, literal, length) != 0) {
+        return -1;
+    }
+    decoder->p += length;
+    return 0;
+}
+
+static char* copy_slice(const char* start, const char* end) {
+    char* copy = malloc(end - start + 1);
+    memcpy(copy, start, end - start);
+    copy[end - start] = '\0';
+    return copy;
+}
+
+static void append_item(Array* array, char* key, char* value, int is_json) {
+    if (array->count >= array->capacity) {
+        array->capacity *= 2;
+        array->items = realloc(array->items, sizeof(ArrayItem) * array->capacity);
+    }
+    array->items[array->count].key = key;
+    array->items[array->count].value = value;
+    array->items[array->count].is_json = is_json;
+    array->count++;
+}
+
+static int decode_container(Decoder* decoder, Array* array);
+
+// Décode une valeur. Avec value NULL elle est seulement validée ; les
+// objets et tableaux imbriqués sont gardés sous forme de texte JSON, les
+// tableaux de l'interpréteur ne pouvant pas contenir de sous-tableaux.
+// true devient "1", false et null deviennent "", comme en conversion PHP.
+static int decode_value(Decoder* decoder, char** value) {
+    skip_whitespace(decoder);
+    if (decoder->p >= decoder->end) {
+        return -1;
+    }
+
+    const char* start = decoder->p;
+    switch (*decoder->p) {
+        case '"':
+            decoder->p++;
+            return decode_string(decoder, value);
+        case '{':
+        case '[':
+            if (decode_container(decoder, NULL) != 0) {
+                return -1;
+            }
+            if (value) {
+                *value = copy_slice(start, decoder->p);
+            }
+            return 0;
+        case 't':
+            if (match_literal(decoder, "true") != 0) return -1;
+            if (value) *value = strdup("1");
+            return 0;
+        case 'f':
+            if (match_literal(decoder, "false") != 0) return -1;
+            if (value) *value = strdup("");
+            return 0;
+        case 'n':
+            if (match_literal(decoder, "null") != 0) return -1;
+            if (value) *value = strdup("");
+            return 0;
+        default:
+            if (decode_number(decoder) != 0) return -1;
+            if (value) *value = copy_slice(start, decoder->p);
+            return 0;
+    }
+}
+
+static int decode_container(Decoder* decoder, Array* array) {
+    char open = *decoder->p++;
+    char close = open == '{' ? '}' : ']';
+    if (++decoder->depth > JSON_MAX_DEPTH) {
+        return -1;
+    }
+
+    skip_whitespace(decoder);
+    if (decoder->p < decoder->end && *decoder->p == close) {
+        decoder->p++;
+        decoder->depth--;
+        return 0;
+    }
+
+    while (1) {
+        char* key = NULL;
+        char* value = NULL;
+
+        if (open == '{') {
+            skip_whitespace(decoder);
+            if (decoder->p >= decoder->end || *decoder->p != '"') {
+                return -1;
+            }
+            decoder->p++;
+            if (decode_string(decoder, array ? &key : NULL) != 0) {
+                return -1;
+            }
+            skip_whitespace(decoder);
+            if (decoder->p >= decoder->end || *decoder->p != ':') {
+                free(key);
+                return -1;
+            }
+            decoder->p++;
+        }
+
+        skip_whitespace(decoder);
+        int is_json = decoder->p < decoder->end && (*decoder->p == '{' || *decoder->p == '[');
+        if (decode_value(decoder, array ? &value : NULL) != 0) {
+            free(key);
+            return -1;
+        }
+        if (array) {
+            append_item(array, key, value, is_json);
+        }
+
+        skip_whitespace(decoder);
+        if (decoder->p >= decoder->end) {
+            return -1;
+        }
+        if (*decoder->p == ',') {
+            decoder->p++;
+            continue;
+        }
+        if (*decoder->p == close) {
+            decoder->p++;
+            decoder->depth--;
+            return 0;
+        }
+        return -1;
+    }
+}
+
+// Un seul passage sur le texte, qui est lu en place sans copie ; json
+// invalide : la valeur reste nulle, comme en PHP.
+int builtin_json_decode(Parser* parser, int argc, Variable* args, Variable* result) {
+    if (argc < 1) {
+        return -1;
+    }
+    if (!args[0].value) {
+        return 0;
+    }
+
+    Decoder decoder = {args[0].value, args[0].value + strlen(args[0].value), 0};
+    skip_whitespace(&decoder);
+
+    if (decoder.p < decoder.end && (*decoder.p == '{' || *decoder.p == '[')) {
+        Array* array = parser_array_create(parser);
+        if (decode_container(&decoder, array) == 0) {
+            skip_whitespace(&decoder);
+            if (decoder.p == decoder.end) {
+                result->array = array;
+                return 0;
+            }
+        }
+        parser_array_release(parser, array);
+        return 0;
+    }
+
+    char* value = NULL;
+    if (decode_value(&decoder, &value) == 0) {
+        skip_whitespace(&decoder);
+        if (decoder.p == decoder.end) {
+            result->value = value;
+            return 0;
+        }
+    }
+    free(value);
+    return 0;
+}
@@ -0,0 +1,11 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include "parser.h"
+
+#define JSON_MAX_DEPTH 512
+
+int builtin_json_encode(Parser* parser, int argc, Variable* args, Variable* result);
+int builtin_json_decode(Parser* parser, int argc, Variable* args, Variable* result);
+
+#endif
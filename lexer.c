@@ -6,7 +6,9 @@
 
 Lexer* lexer_create(const char* source) {
     Lexer* lexer = malloc(sizeof(Lexer));
-    lexer->source = strdup(source);
+    lexer->source_capacity = strlen(source) + 1;
+    lexer->source = malloc(lexer->source_capacity);
+    memcpy(lexer->source, source, lexer->source_capacity);
     lexer->position = 0;
     lexer->token_count = 0;
     lexer->token_capacity = 10;
@@ -14,15 +16,34 @@ Lexer* lexer_create(const char* source) {
     return lexer;
 }
 
-void lexer_free(Lexer* lexer) {
+static void free_token_values(Lexer* lexer) {
     for (int i = 0; i < lexer->token_count; i++) {
-        free(lexer->tokens[i].value);
+        if (lexer->tokens[i].type != TOKEN_INLINE_HTML) {
+            free(lexer->tokens[i].value);
+        }
     }
+}
+
+void lexer_free(Lexer* lexer) {
+    free_token_values(lexer);
     free(lexer->tokens);
     free(lexer->source);
     free(lexer);
 }
 
+void lexer_reset(Lexer* lexer, const char* source) {
+    free_token_values(lexer);
+    lexer->token_count = 0;
+    lexer->position = 0;
+
+    int length = strlen(source) + 1;
+    if (length > lexer->source_capacity) {
+        lexer->source_capacity = length;
+        lexer->source = realloc(lexer->source, lexer->source_capacity);
+    }
+    memcpy(lexer->source, source, length);
+}
+
 static void add_token(Lexer* lexer, TokenType type, char* value) {
     if (lexer->token_count >= lexer->token_capacity) {
         lexer->token_capacity *= 2;
@@ -30,13 +51,53 @@ static void add_token(Lexer* lexer, TokenType type, char* value) {
     }
     lexer->tokens[lexer->token_count].type = type;
     lexer->tokens[lexer->token_count].value = value ? strdup(value) : NULL;
+    lexer->tokens[lexer->token_count].length = value ? strlen(value) : 0;
     lexer->token_count++;
 }
 
+// Le texte HTML n'est pas copié : le token référence directement la source.
+static void add_inline_html(Lexer* lexer, int start, int length) {
+    add_token(lexer, TOKEN_INLINE_HTML, NULL);
+    lexer->tokens[lexer->token_count - 1].value = &lexer->source[start];
+    lexer->tokens[lexer->token_count - 1].length = length;
+}
+
+static int is_open_tag(const char* text) {
+    return strncmp(text, "<?php", 5) == 0 || strncmp(text, "<?=", 3) == 0;
+}
+
+static int is_identifier_char(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
 void lexer_tokenize(Lexer* lexer) {
+    int in_php = 0;
     while (lexer->source[lexer->position] != '\0') {
         char c = lexer->source[lexer->position];
 
+        if (!in_php) {
+            int start = lexer->position;
+            const char* tag = strchr(&lexer->source[start], '<');
+            while (tag && !is_open_tag(tag)) {
+                tag = strchr(tag + 1, '<');
+            }
+            int length = tag ? tag - &lexer->source[start] : (int)strlen(&lexer->source[start]);
+            if (length > 0) {
+                add_inline_html(lexer, start, length);
+            }
+            lexer->position += length;
+            if (tag) {
+                if (tag[2] == '=') {
+                    add_token(lexer, TOKEN_ECHO, NULL);
+                    lexer->position += 3;
+                } else {
+                    lexer->position += 5;
+                }
+                in_php = 1;
+            }
+            continue;
+        }
+
         if (isspace(c)) {
             lexer->position++;
             continue;
@@ -47,48 +108,103 @@ void lexer_tokenize(Lexer* lexer) {
             continue;
         }
 
+        if (strncmp(&lexer->source[lexer->position], "?>", 2) == 0) {
+            // "?>" termine l'instruction et mange un saut de ligne, comme PHP
+            add_token(lexer, TOKEN_SEMICOLON, NULL);
+            lexer->position += 2;
+            if (lexer->source[lexer->position] == '\n') {
+                lexer->position++;
+            } else if (strncmp(&lexer->source[lexer->position], "\r\n", 2) == 0) {
+                lexer->position += 2;
+            }
+            in_php = 0;
+            continue;
+        }
+
         if (strncmp(&lexer->source[lexer->position], "echo", 4) == 0 && 
-            !isalnum(lexer->source[lexer->position + 4])) {
+            !is_identifier_char(lexer->source[lexer->position + 4])) {
             add_token(lexer, TOKEN_ECHO, NULL);
             lexer->position += 4;
             continue;
         }
 
         if (strncmp(&lexer->source[lexer->position], "for", 3) == 0 && 
-            !isalnum(lexer->source[lexer->position + 3])) {
+            !is_identifier_char(lexer->source[lexer->position + 3])) {
             add_token(lexer, TOKEN_FOR, NULL);
             lexer->position += 3;
             continue;
         }
 
         if (strncmp(&lexer->source[lexer->position], "if", 2) == 0 && 
-            !isalnum(lexer->source[lexer->position + 2])) {
+            !is_identifier_char(lexer->source[lexer->position + 2])) {
             add_token(lexer, TOKEN_IF, NULL);
             lexer->position += 2;
             continue;
         }
 
         if (strncmp(&lexer->source[lexer->position], "else", 4) == 0 && 
-            !isalnum(lexer->source[lexer->position + 4])) {
+            !is_identifier_char(lexer->source[lexer->position + 4])) {
             add_token(lexer, TOKEN_ELSE, NULL);
             lexer->position += 4;
             continue;
         }
 
         if (strncmp(&lexer->source[lexer->position], "foreach", 7) == 0 && 
-            !isalnum(lexer->source[lexer->position + 7])) {
+            !is_identifier_char(lexer->source[lexer->position + 7])) {
             add_token(lexer, TOKEN_FOREACH, NULL);
             lexer->position += 7;
             continue;
         }
 
         if (strncmp(&lexer->source[lexer->position], "as", 2) == 0 && 
-            !isalnum(lexer->source[lexer->position + 2])) {
+            !is_identifier_char(lexer->source[lexer->position + 2])) {
             add_token(lexer, TOKEN_AS, NULL);
             lexer->position += 2;
             continue;
         }
 
+        if (strncmp(&lexer->source[lexer->position], "include_once", 12) == 0 && 
+            !is_identifier_char(lexer->source[lexer->position + 12])) {
+            add_token(lexer, TOKEN_INCLUDE_ONCE, NULL);
+            lexer->position += 12;
+            continue;
+        }
+
+        if (strncmp(&lexer->source[lexer->position], "include", 7) == 0 && 
+            !is_identifier_char(lexer->source[lexer->position + 7])) {
+            add_token(lexer, TOKEN_INCLUDE, NULL);
+            lexer->position += 7;
+            continue;
+        }
+
+        if (strncmp(&lexer->source[lexer->position], "require_once", 12) == 0 && 
+            !is_identifier_char(lexer->source[lexer->position + 12])) {
+            add_token(lexer, TOKEN_REQUIRE_ONCE, NULL);
+            lexer->position += 12;
+            continue;
+        }
+
+        if (strncmp(&lexer->source[lexer->position], "require", 7) == 0 && 
+            !is_identifier_char(lexer->source[lexer->position + 7])) {
+            add_token(lexer, TOKEN_REQUIRE, NULL);
+            lexer->position += 7;
+            continue;
+        }
+
+        if (isalpha(c) || c == '_') {
+            int start = lexer->position;
+            while (is_identifier_char(lexer->source[lexer->position])) {
+                lexer->position++;
+            }
+            int length = lexer->position - start;
+            char* value = malloc(length + 1);
+            strncpy(value, &lexer->source[start], length);
+            value[length] = '\0';
+            add_token(lexer, TOKEN_IDENTIFIER, value);
+            free(value);
+            continue;
+        }
+
         if (c == '$') {
             int start = lexer->position + 1;
             while (isalnum(lexer->source[lexer->position + 1])) {
@@ -224,7 +340,9 @@ void lexer_tokenize(Lexer* lexer) {
             strncpy(value, &lexer->source[start], length);
             value[length] = '\0';
             add_token(lexer, TOKEN_STRING, value);
-            lexer->position++;
+            if (lexer->source[lexer->position] == '"') {
+                lexer->position++;
+            }
             free(value);
             continue;
         }
@@ -28,16 +28,24 @@ typedef enum {
     TOKEN_OPEN_BRACKET,// [
     TOKEN_CLOSE_BRACKET,// ]
     TOKEN_COMMA,       // ,
+    TOKEN_IDENTIFIER,  // Nom de fonction
+    TOKEN_INCLUDE,
+    TOKEN_INCLUDE_ONCE,
+    TOKEN_REQUIRE,
+    TOKEN_REQUIRE_ONCE,
+    TOKEN_INLINE_HTML, // Texte hors des balises PHP
     TOKEN_UNKNOWN
 } TokenType;
 
 typedef struct {
     TokenType type;
-    char* value;
+    char* value;  // Pour TOKEN_INLINE_HTML : pointe dans source, non terminé
+    int length;
 } Token;
 
 typedef struct {
     char* source;
+    int source_capacity;
     int position;
     Token* tokens;
     int token_count;
@@ -46,6 +54,7 @@ typedef struct {
 
 Lexer* lexer_create(const char* source);
 void lexer_free(Lexer* lexer);
+void lexer_reset(Lexer* lexer, const char* source); // Garde les buffers alloués
 void lexer_tokenize(Lexer* lexer);
 
 #endif
\ No newline at end of file
@@ -1,8 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include "lexer.h"
-#include "parser.h"
-#include "utils.h"
+#include "include.h"
+#include "interpreter.h"
+#include "regex.h"
 
 int main(int argc, char* argv[]) {
     if (argc != 2) {
@@ -12,21 +12,18 @@ int main(int argc, char* argv[]) {
     }
 
     const char* filename = argv[1];
-    char* php_code = read_file(filename);
+    Interpreter* interpreter = interpreter_create();
     
-    if (!php_code) {
+    if (interpreter_load_file(interpreter, filename) != 0) {
+        interpreter_free(interpreter);
         return 1;
     }
     
-    Lexer* lexer = lexer_create(php_code);
-    lexer_tokenize(lexer);
+    interpreter_run(interpreter, NULL, 0);
+    int status = interpreter_halted(interpreter) ? 255 : 0; // Code de sortie de PHP
+    interpreter_free(interpreter);
+    compiled_file_cache_clear();
+    regex_cache_clear();
     
-    Parser* parser = parser_create(lexer);
-    parser_run(parser);
-    
-    parser_free(parser);
-    lexer_free(lexer);
-    free(php_code);
-    
-    return 0;
-}
\ No newline at end of file
+    return status;
+}
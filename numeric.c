@@ -0,0 +1,50 @@
+#include <stdlib.h>
+#include <string.h>
+#include "numeric.h"
+
+// max($a, $b, ...) ou max($tableau) : retourne la valeur elle-même, comme
+// PHP. Avec deux scalaires, utilisable comme réducteur de parallel_reduce.
+static int select_value(int argc, Variable* args, Variable* result, int want_max) {
+    const char* best = NULL;
+    double best_number = 0;
+
+    if (argc == 1 && args[0].array) {
+        Array* array = args[0].array;
+        for (int i = 0; i < array->count; i++) {
+            const char* value = array->items[i].value ? array->items[i].value : "";
+            double number = atof(value);
+            if (!best || (want_max ? number > best_number : number < best_number)) {
+                best = value;
+                best_number = number;
+            }
+        }
+    } else {
+        for (int i = 0; i < argc; i++) {
+            if (args[i].array) {
+                return -1;
+            }
+            const char* value = args[i].value ? args[i].value : "";
+            double number = atof(value);
+            if (!best || (want_max ? number > best_number : number < best_number)) {
+                best = value;
+                best_number = number;
+            }
+        }
+    }
+
+    if (!best) {
+        return -1;
+    }
+    result->value = strdup(best);
+    return 0;
+}
+
+int builtin_max(Parser* parser, int argc, Variable* args, Variable* result) {
+    (void)parser;
+    return select_value(argc, args, result, 1);
+}
+
+int builtin_min(Parser* parser, int argc, Variable* args, Variable* result) {
+    (void)parser;
+    return select_value(argc, args, result, 0);
+}
@@ -0,0 +1,9 @@
+#ifndef NUMERIC_H
+#define NUMERIC_H
+
+#include "parser.h"
+
+int builtin_max(Parser* parser, int argc, Variable* args, Variable* result);
+int builtin_min(Parser* parser, int argc, Variable* args, Variable* result);
+
+#endif
@@ -0,0 +1,291 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "parallel.h"
+#include "builtins.h"
+#include "stream.h"
+
+#define CHUNKS_PER_THREAD 4
+
+typedef struct {
+    void (*function)(void* context, int chunk);
+    void* context;
+    int chunk_count;
+    int next_chunk;
+    int finished_chunks;
+} Job;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t pool_busy = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static Job* current_job = NULL;
+static int thread_count = 1;
+
+// Prend un chunk du travail courant et l'exécute ; pool_mutex doit être tenu.
+static void run_one_chunk(Job* job) {
+    int chunk = job->next_chunk++;
+    pthread_mutex_unlock(&pool_mutex);
+    job->function(job->context, chunk);
+    pthread_mutex_lock(&pool_mutex);
+    if (++job->finished_chunks == job->chunk_count) {
+        pthread_cond_broadcast(&work_done);
+    }
+}
+
+static void* worker_main(void* unused) {
+    (void)unused;
+    pthread_mutex_lock(&pool_mutex);
+    while (1) {
+        while (!current_job || current_job->next_chunk >= current_job->chunk_count) {
+            pthread_cond_wait(&work_ready, &pool_mutex);
+        }
+        run_one_chunk(current_job);
+    }
+    return NULL;
+}
+
+static void start_pool(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_count = cores > 1 ? (int)cores : 1;
+    for (int i = 1; i < thread_count; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, worker_main, NULL) != 0) {
+            thread_count = i;
+            break;
+        }
+        pthread_detach(thread);
+    }
+}
+
+int parallel_chunk_count(int item_count, int min_chunk_size) {
+    pthread_once(&pool_once, start_pool);
+    int chunks = thread_count * CHUNKS_PER_THREAD;
+    if (item_count / min_chunk_size < chunks) {
+        chunks = item_count / min_chunk_size;
+    }
+    return chunks > 0 ? chunks : 1;
+}
+
+void parallel_run(int chunk_count, void (*function)(void* context, int chunk), void* context) {
+    pthread_once(&pool_once, start_pool);
+    if (chunk_count <= 1 || thread_count <= 1 || pthread_mutex_trylock(&pool_busy) != 0) {
+        for (int i = 0; i < chunk_count; i++) {
+            function(context, i);
+        }
+        return;
+    }
+    
+    Job job = {function, context, chunk_count, 0, 0};
+    pthread_mutex_lock(&pool_mutex);
+    current_job = &job;
+    pthread_cond_broadcast(&work_ready);
+    while (job.next_chunk < job.chunk_count) {
+        run_one_chunk(&job);
+    }
+    while (job.finished_chunks < job.chunk_count) {
+        pthread_cond_wait(&work_done, &pool_mutex);
+    }
+    current_job = NULL;
+    pthread_mutex_unlock(&pool_mutex);
+    pthread_mutex_unlock(&pool_busy);
+}
+
+static void chunk_bounds(int count, int chunk_count, int chunk, int* start, int* end) {
+    *start = (int)((long)count * chunk / chunk_count);
+    *end = (int)((long)count * (chunk + 1) / chunk_count);
+}
+
+// Chaque chunk a son propre Parser : fichiers ouverts et tableaux
+// temporaires ne sont jamais partagés entre threads.
+typedef struct {
+    Parser* parser;
+    Array* input;
+    Array* output;
+    BuiltinFunction callback;
+    char** partials;
+    int chunk_count;
+    int array_results;  // Le callback a retourné un tableau, qui ne peut pas être stocké
+    int failures;       // Le callback a échoué sur au moins un élément
+} MapContext;
+
+static const char* item_value(const Array* array, int index) {
+    return array->items[index].value ? array->items[index].value : "";
+}
+
+static char* call_callback(MapContext* context, Parser* worker, int argc, Variable* args) {
+    Variable result = {NULL, NULL, NULL};
+    if (context->callback(worker, argc, args, &result) != 0) {
+        __atomic_store_n(&context->failures, 1, __ATOMIC_RELAXED);
+    }
+    if (result.array) {
+        parser_array_release(worker, result.array);
+        __atomic_store_n(&context->array_results, 1, __ATOMIC_RELAXED);
+    }
+    return result.value;
+}
+
+static void warn_callback_results(const MapContext* context, const char* function, const char* callback) {
+    if (context->array_results) {
+        fprintf(stderr, "Avertissement: %s(): %s retourne un tableau, valeur ignorée\n", 
+                function, callback);
+    }
+    if (context->failures) {
+        fprintf(stderr, "Avertissement: %s(): %s a échoué sur certains éléments\n", 
+                function, callback);
+    }
+}
+
+// Les fichiers ouverts appartiennent au Parser du chunk, libéré à la fin :
+// un handle retourné par fopen désignerait un autre fichier chez l'appelant.
+static BuiltinFunction parallel_callback(const char* name) {
+    BuiltinFunction callback = builtin_lookup(name);
+    if (callback == builtin_fopen || callback == builtin_fgets || callback == builtin_fwrite || 
+        callback == builtin_fclose || callback == builtin_feof) {
+        return NULL;
+    }
+    return callback;
+}
+
+static void map_chunk(void* context, int chunk) {
+    MapContext* map = context;
+    Parser* worker = parser_create(map->parser->lexer);
+    int start, end;
+    chunk_bounds(map->input->count, map->chunk_count, chunk, &start, &end);
+    
+    for (int i = start; i < end; i++) {
+        Variable arg = {NULL, (char*)item_value(map->input, i), NULL};
+        char* value = call_callback(map, worker, 1, &arg);
+        map->output->items[i].key = map->input->items[i].key ? strdup(map->input->items[i].key) : NULL;
+        map->output->items[i].value = value ? value : strdup("");
+        map->output->items[i].is_json = 0;
+    }
+    parser_free(worker);
+}
+
+static Array* create_sized_array(Parser* parser, int count) {
+    Array* array = parser_array_create(parser);
+    if (array->capacity < count) {
+        array->capacity = count;
+        array->items = realloc(array->items, sizeof(ArrayItem) * array->capacity);
+    }
+    array->count = count;
+    return array;
+}
+
+int builtin_parallel_map(Parser* parser, int argc, Variable* args, Variable* result) {
+    if (argc < 2 || !args[0].array || !args[1].value) {
+        return -1;
+    }
+    BuiltinFunction callback = parallel_callback(args[1].value);
+    if (!callback) {
+        return -1;
+    }
+    
+    MapContext map = {parser, args[0].array, NULL, callback, NULL, 0, 0, 0};
+    map.output = create_sized_array(parser, map.input->count);
+    map.chunk_count = parallel_chunk_count(map.input->count, 1);
+    parallel_run(map.chunk_count, map_chunk, &map);
+    warn_callback_results(&map, "parallel_map", args[1].value);
+    
+    result->array = map.output;
+    return 0;
+}
+
+// Réduction par chunk puis combinaison des résultats partiels dans l'ordre :
+// le callback doit être associatif.
+static void reduce_chunk(void* context, int chunk) {
+    MapContext* reduce = context;
+    Parser* worker = parser_create(reduce->parser->lexer);
+    int start, end;
+    chunk_bounds(reduce->input->count, reduce->chunk_count, chunk, &start, &end);
+    
+    char* carry = start < end ? strdup(item_value(reduce->input, start)) : NULL;
+    for (int i = start + 1; i < end; i++) {
+        Variable args[2] = {{NULL, carry, NULL}, {NULL, (char*)item_value(reduce->input, i), NULL}};
+        char* value = call_callback(reduce, worker, 2, args);
+        free(carry);
+        carry = value ? value : strdup("");
+    }
+    reduce->partials[chunk] = carry;
+    parser_free(worker);
+}
+
+int builtin_parallel_reduce(Parser* parser, int argc, Variable* args, Variable* result) {
+    if (argc < 2 || !args[0].array || !args[1].value) {
+        return -1;
+    }
+    BuiltinFunction callback = parallel_callback(args[1].value);
+    if (!callback) {
+        return -1;
+    }
+    
+    MapContext reduce = {parser, args[0].array, NULL, callback, NULL, 0, 0, 0};
+    reduce.chunk_count = parallel_chunk_count(reduce.input->count, 1);
+    reduce.partials = calloc(reduce.chunk_count, sizeof(char*));
+    parallel_run(reduce.chunk_count, reduce_chunk, &reduce);
+    
+    char* carry = argc > 2 && args[2].value ? strdup(args[2].value) : NULL;
+    for (int i = 0; i < reduce.chunk_count; i++) {
+        if (!reduce.partials[i]) {
+            continue;
+        }
+        if (!carry) {
+            carry = reduce.partials[i];
+            continue;
+        }
+        Variable pair[2] = {{NULL, carry, NULL}, {NULL, reduce.partials[i], NULL}};
+        char* value = call_callback(&reduce, parser, 2, pair);
+        free(carry);
+        free(reduce.partials[i]);
+        carry = value ? value : strdup("");
+    }
+    free(reduce.partials);
+    warn_callback_results(&reduce, "parallel_reduce", args[1].value);
+    
+    result->value = carry;
+    return 0;
+}
+
+typedef struct {
+    Array* input;
+    double* sums;
+    int chunk_count;
+} SumContext;
+
+static void sum_chunk(void* context, int chunk) {
+    SumContext* sum = context;
+    int start, end;
+    chunk_bounds(sum->input->count, sum->chunk_count, chunk, &start, &end);
+    
+    double total = 0;
+    for (int i = start; i < end; i++) {
+        total += atof(item_value(sum->input, i));
+    }
+    sum->sums[chunk] = total;
+}
+
+int builtin_array_sum(Parser* parser, int argc, Variable* args, Variable* result) {
+    (void)parser;
+    if (argc < 1 || !args[0].array) {
+        return -1;
+    }
+    
+    SumContext sum = {args[0].array, NULL, 0};
+    sum.chunk_count = parallel_chunk_count(sum.input->count, 65536);
+    sum.sums = malloc(sizeof(double) * sum.chunk_count);
+    parallel_run(sum.chunk_count, sum_chunk, &sum);
+    
+    double total = 0;
+    for (int i = 0; i < sum.chunk_count; i++) {
+        total += sum.sums[i];
+    }
+    free(sum.sums);
+    
+    result->value = malloc(32);
+    snprintf(result->value, 32, "%.2f", total);
+    return 0;
+}
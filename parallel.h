@@ -0,0 +1,15 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "parser.h"
+
+// Exécute function(context, chunk) pour chaque chunk sur le pool de threads.
+// Le thread appelant participe ; si le pool est occupé, tout s'exécute sur place.
+void parallel_run(int chunk_count, void (*function)(void* context, int chunk), void* context);
+int parallel_chunk_count(int item_count, int min_chunk_size);
+
+int builtin_parallel_map(Parser* parser, int argc, Variable* args, Variable* result);
+int builtin_parallel_reduce(Parser* parser, int argc, Variable* args, Variable* result);
+int builtin_array_sum(Parser* parser, int argc, Variable* args, Variable* result);
+
+#endif
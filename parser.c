@@ -2,6 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include "parser.h"
+#include "builtins.h"
+#include "include.h"
+#include "stream.h"
+
+#define MAX_CALL_ARGS 8
 
 Parser* parser_create(Lexer* lexer) {
     Parser* parser = malloc(sizeof(Parser));
@@ -13,26 +18,105 @@ Parser* parser_create(Lexer* lexer) {
     for (int i = 0; i < parser->var_capacity; i++) {
         parser->variables[i].array = NULL;
     }
+    parser->array_pool_count = 0;
+    parser->array_pool_capacity = 10;
+    parser->array_pool = malloc(sizeof(Array*) * parser->array_pool_capacity);
+    parser->output = NULL;
+    parser->output_size = 0;
+    parser->output_length = 0;
+    parser->streams = NULL;
+    parser->stream_count = 0;
+    parser->stream_capacity = 0;
+    parser->stream_closes = 0;
+    parser->filename = NULL;
+    parser->included_count = 0;
+    parser->included_capacity = 4;
+    parser->included = malloc(sizeof(IncludedFile) * parser->included_capacity);
+    parser->halted = 0;
     return parser;
 }
 
-void parser_free(Parser* parser) {
+Array* parser_array_create(Parser* parser) {
+    if (parser->array_pool_count > 0) {
+        return parser->array_pool[--parser->array_pool_count];
+    }
+    Array* array = malloc(sizeof(Array));
+    array->count = 0;
+    array->capacity = 10;
+    array->items = malloc(sizeof(ArrayItem) * array->capacity);
+    return array;
+}
+
+void parser_array_release(Parser* parser, Array* array) {
+    for (int j = 0; j < array->count; j++) {
+        free(array->items[j].key);
+        free(array->items[j].value);
+    }
+    array->count = 0;
+    
+    if (parser->array_pool_count >= parser->array_pool_capacity) {
+        parser->array_pool_capacity *= 2;
+        parser->array_pool = realloc(parser->array_pool, 
+                                     sizeof(Array*) * parser->array_pool_capacity);
+    }
+    parser->array_pool[parser->array_pool_count++] = array;
+}
+
+void parser_reset(Parser* parser) {
     for (int i = 0; i < parser->var_count; i++) {
         free(parser->variables[i].name);
         free(parser->variables[i].value);
         if (parser->variables[i].array) {
-            for (int j = 0; j < parser->variables[i].array->count; j++) {
-                free(parser->variables[i].array->items[j].key);
-                free(parser->variables[i].array->items[j].value);
-            }
-            free(parser->variables[i].array->items);
-            free(parser->variables[i].array);
+            parser_array_release(parser, parser->variables[i].array);
+            parser->variables[i].array = NULL;
         }
     }
+    parser->var_count = 0;
+    parser->position = 0;
+    parser->output_length = 0;
+    parser->included_count = 0;
+    parser->halted = 0;
+    stream_close_all(parser);
+}
+
+void parser_free(Parser* parser) {
+    parser_reset(parser);
+    for (int i = 0; i < parser->array_pool_count; i++) {
+        free(parser->array_pool[i]->items);
+        free(parser->array_pool[i]);
+    }
+    free(parser->array_pool);
+    free(parser->streams);
+    free(parser->included);
     free(parser->variables);
     free(parser);
 }
 
+void parser_set_output(Parser* parser, char* buffer, size_t size) {
+    parser->output = buffer;
+    parser->output_size = size;
+    parser->output_length = 0;
+    if (buffer && size > 0) {
+        buffer[0] = '\0';
+    }
+}
+
+static void emit(Parser* parser, const char* text, size_t length) {
+    size_t used = parser->output_length;
+    parser->output_length += length;
+    if (!parser->output) {
+        fwrite(text, 1, length, stdout);
+        return;
+    }
+    
+    if (used + 1 < parser->output_size) {
+        size_t available = parser->output_size - 1 - used;
+        size_t count = length < available ? length : available;
+        memcpy(parser->output + used, text, count);
+        parser->output[used + count] = '\0';
+    }
+}
+
 static Token current_token(Parser* parser) {
     return parser->lexer->tokens[parser->position];
 }
@@ -59,19 +143,15 @@ static Array* get_variable_array(Parser* parser, const char* name) {
     return NULL;
 }
 
-static void set_variable(Parser* parser, const char* name, const char* value, Array* array) {
+// Prend possession de value et array, sans copie.
+static void set_variable_owned(Parser* parser, const char* name, char* value, Array* array) {
     for (int i = 0; i < parser->var_count; i++) {
         if (strcmp(parser->variables[i].name, name) == 0) {
             free(parser->variables[i].value);
             if (parser->variables[i].array) {
-                for (int j = 0; j < parser->variables[i].array->count; j++) {
-                    free(parser->variables[i].array->items[j].key);
-                    free(parser->variables[i].array->items[j].value);
-                }
-                free(parser->variables[i].array->items);
-                free(parser->variables[i].array);
+                parser_array_release(parser, parser->variables[i].array);
             }
-            parser->variables[i].value = value ? strdup(value) : NULL;
+            parser->variables[i].value = value;
             parser->variables[i].array = array;
             return;
         }
@@ -87,14 +167,48 @@ static void set_variable(Parser* parser, const char* name, const char* value, Ar
     }
     
     parser->variables[parser->var_count].name = strdup(name);
-    parser->variables[parser->var_count].value = value ? strdup(value) : NULL;
+    parser->variables[parser->var_count].value = value;
     parser->variables[parser->var_count].array = array;
     parser->var_count++;
 }
 
+static void set_variable(Parser* parser, const char* name, const char* value, Array* array) {
+    set_variable_owned(parser, name, value ? strdup(value) : NULL, array);
+}
+
+// Affectation depuis une tranche non terminée ; réutilise le buffer existant.
+static void set_variable_length(Parser* parser, const char* name, const char* text, size_t length) {
+    int i;
+    for (i = 0; i < parser->var_count; i++) {
+        if (strcmp(parser->variables[i].name, name) == 0) {
+            break;
+        }
+    }
+    if (i == parser->var_count) {
+        set_variable(parser, name, "", NULL);
+    }
+    
+    Variable* variable = &parser->variables[i];
+    if (variable->array) {
+        parser_array_release(parser, variable->array);
+        variable->array = NULL;
+    }
+    variable->value = realloc(variable->value, length + 1);
+    memcpy(variable->value, text, length);
+    variable->value[length] = '\0';
+}
+
+void parser_set_variable(Parser* parser, const char* name, const char* value) {
+    set_variable(parser, name, value, NULL);
+}
+
+void parser_set_array(Parser* parser, const char* name, Array* array) {
+    set_variable(parser, name, NULL, array);
+}
+
 static char* operate_values(const char* val1, const char* val2, TokenType operator) {
-    double num1 = atof(val1);
-    double num2 = atof(val2);
+    double num1 = val1 ? atof(val1) : 0;
+    double num2 = val2 ? atof(val2) : 0;
     double result;
     
     switch (operator) {
@@ -140,7 +254,8 @@ static int evaluate_condition(Parser* parser, char* left, TokenType operator, ch
 static void parse_expression(Parser* parser);
 
 static void parse_block(Parser* parser) {
-    while (current_token(parser).type != TOKEN_CLOSE_BRACE && 
+    while (!parser->halted && 
+           current_token(parser).type != TOKEN_CLOSE_BRACE && 
            current_token(parser).type != TOKEN_EOF) {
         parse_expression(parser);
     }
@@ -150,10 +265,7 @@ static void parse_block(Parser* parser) {
 }
 
 static Array* parse_array(Parser* parser) {
-    Array* array = malloc(sizeof(Array));
-    array->count = 0;
-    array->capacity = 10;
-    array->items = malloc(sizeof(ArrayItem) * array->capacity);
+    Array* array = parser_array_create(parser);
     
     advance(parser); // [
     
@@ -179,8 +291,9 @@ static Array* parse_array(Parser* parser) {
             advance(parser);
         }
         
-        array->items[array->count].key = key ? strdup(key) : NULL;
+        array->items[array->count].key = key;
         array->items[array->count].value = strdup(value);
+        array->items[array->count].is_json = 0;
         array->count++;
         
         if (current_token(parser).type == TOKEN_COMMA) {
@@ -195,6 +308,186 @@ static Array* parse_array(Parser* parser) {
     return array;
 }
 
+static void parse_call(Parser* parser, Variable* result);
+
+// Une variable passée en argument est empruntée (name non NULL),
+// une valeur temporaire appartient à l'argument.
+static void parse_argument(Parser* parser, Variable* arg) {
+    Token token = current_token(parser);
+    arg->name = NULL;
+    arg->value = NULL;
+    arg->array = NULL;
+    
+    if (token.type == TOKEN_VARIABLE) {
+        arg->name = token.value;
+        arg->value = get_variable_value(parser, token.value);
+        arg->array = get_variable_array(parser, token.value);
+        advance(parser);
+    } else if (token.type == TOKEN_OPEN_BRACKET) {
+        arg->array = parse_array(parser);
+    } else if (token.type == TOKEN_IDENTIFIER) {
+        parse_call(parser, arg);
+    } else if (token.type != TOKEN_EOF) {
+        arg->value = token.value ? strdup(token.value) : NULL;
+        advance(parser);
+    }
+}
+
+static void release_value(Parser* parser, Variable* value) {
+    if (value->name) {
+        return;
+    }
+    free(value->value);
+    if (value->array) {
+        parser_array_release(parser, value->array);
+    }
+}
+
+static void parse_call(Parser* parser, Variable* result) {
+    result->name = NULL;
+    result->value = NULL;
+    result->array = NULL;
+    
+    char* name = current_token(parser).value;
+    advance(parser);
+    if (current_token(parser).type != TOKEN_OPEN_PAREN) {
+        return;
+    }
+    advance(parser); // (
+    
+    Variable args[MAX_CALL_ARGS];
+    int argc = 0;
+    while (current_token(parser).type != TOKEN_CLOSE_PAREN && 
+           current_token(parser).type != TOKEN_EOF) {
+        Variable arg;
+        parse_argument(parser, &arg);
+        if (argc < MAX_CALL_ARGS) {
+            args[argc++] = arg;
+        } else {
+            release_value(parser, &arg);
+        }
+        
+        if (current_token(parser).type == TOKEN_COMMA) {
+            advance(parser); // ,
+        }
+    }
+    if (current_token(parser).type == TOKEN_CLOSE_PAREN) {
+        advance(parser); // )
+    }
+    
+    BuiltinFunction function = builtin_lookup(name);
+    if (!function) {
+        fprintf(stderr, "Erreur: fonction inconnue %s()\n", name);
+    } else if (function(parser, argc, args, result) != 0) {
+        fprintf(stderr, "Erreur: arguments invalides pour %s()\n", name);
+    }
+    
+    for (int i = 0; i < argc; i++) {
+        release_value(parser, &args[i]);
+    }
+}
+
+// Chemin relatif : essayé tel quel, puis depuis le dossier du fichier courant
+static CompiledFile* acquire_include(Parser* parser, const char* path) {
+    CompiledFile* file = compiled_file_acquire(path);
+    if (file || path[0] == '/' || !parser->filename) {
+        return file;
+    }
+    
+    const char* slash = strrchr(parser->filename, '/');
+    if (!slash) {
+        return NULL;
+    }
+    int dir_length = slash - parser->filename + 1;
+    char* full_path = malloc(dir_length + strlen(path) + 1);
+    memcpy(full_path, parser->filename, dir_length);
+    strcpy(full_path + dir_length, path);
+    file = compiled_file_acquire(full_path);
+    free(full_path);
+    return file;
+}
+
+static int already_included(Parser* parser, CompiledFile* file) {
+    for (int i = 0; i < parser->included_count; i++) {
+        if (parser->included[i].device == file->device && 
+            parser->included[i].inode == file->inode) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void mark_included(Parser* parser, CompiledFile* file) {
+    if (already_included(parser, file)) {
+        return;
+    }
+    if (parser->included_count >= parser->included_capacity) {
+        parser->included_capacity *= 2;
+        parser->included = realloc(parser->included, 
+                                   sizeof(IncludedFile) * parser->included_capacity);
+    }
+    parser->included[parser->included_count].device = file->device;
+    parser->included[parser->included_count].inode = file->inode;
+    parser->included_count++;
+}
+
+static void parse_include(Parser* parser) {
+    TokenType type = current_token(parser).type;
+    int once = type == TOKEN_INCLUDE_ONCE || type == TOKEN_REQUIRE_ONCE;
+    int required = type == TOKEN_REQUIRE || type == TOKEN_REQUIRE_ONCE;
+    advance(parser);
+    
+    int parenthesized = current_token(parser).type == TOKEN_OPEN_PAREN;
+    if (parenthesized) {
+        advance(parser); // (
+    }
+    Variable path;
+    parse_argument(parser, &path);
+    if (parenthesized && current_token(parser).type == TOKEN_CLOSE_PAREN) {
+        advance(parser); // )
+    }
+    if (current_token(parser).type == TOKEN_SEMICOLON) {
+        advance(parser);
+    }
+    
+    CompiledFile* file = path.value ? acquire_include(parser, path.value) : NULL;
+    if (!file) {
+        if (required) {
+            fprintf(stderr, "Erreur fatale: require(%s): impossible d'ouvrir le fichier\n", 
+                    path.value ? path.value : "");
+            parser->halted = 1;
+        } else {
+            fprintf(stderr, "Avertissement: include(%s): impossible d'ouvrir le fichier\n", 
+                    path.value ? path.value : "");
+        }
+        release_value(parser, &path);
+        return;
+    }
+    release_value(parser, &path);
+    
+    if (once && already_included(parser, file)) {
+        compiled_file_release(file);
+        return;
+    }
+    mark_included(parser, file);
+    
+    Lexer* lexer = parser->lexer;
+    int position = parser->position;
+    const char* filename = parser->filename;
+    
+    parser->lexer = file->lexer;
+    parser->position = 0;
+    parser->filename = file->path;
+    while (!parser->halted && current_token(parser).type != TOKEN_EOF) {
+        parse_expression(parser);
+    }
+    
+    parser->lexer = lexer;
+    parser->position = position;
+    parser->filename = filename;
+    compiled_file_release(file);
+}
+
 static void parse_expression(Parser* parser) {
     Token token = current_token(parser);
     
@@ -203,14 +496,21 @@ static void parse_expression(Parser* parser) {
         token = current_token(parser);
         
         if (token.type == TOKEN_STRING) {
-            printf("%s", token.value);
+            emit(parser, token.value, token.length);
             advance(parser);
         } else if (token.type == TOKEN_VARIABLE) {
             char* value = get_variable_value(parser, token.value);
             if (value) {
-                printf("%s", value);
+                emit(parser, value, strlen(value));
             }
             advance(parser);
+        } else if (token.type == TOKEN_IDENTIFIER) {
+            Variable result;
+            parse_call(parser, &result);
+            if (result.value) {
+                emit(parser, result.value, strlen(result.value));
+            }
+            release_value(parser, &result);
         }
         
         if (current_token(parser).type == TOKEN_SEMICOLON) {
@@ -231,10 +531,16 @@ static void parse_expression(Parser* parser) {
                 value = strdup(token.value);
                 advance(parser);
             } else if (token.type == TOKEN_VARIABLE) {
-                value = strdup(get_variable_value(parser, token.value));
+                char* source = get_variable_value(parser, token.value);
+                value = strdup(source ? source : "");
                 advance(parser);
             } else if (token.type == TOKEN_OPEN_BRACKET) {
                 array = parse_array(parser);
+            } else if (token.type == TOKEN_IDENTIFIER) {
+                Variable result;
+                parse_call(parser, &result);
+                value = result.value;
+                array = result.array;
             }
             
             TokenType operator = current_token(parser).type;
@@ -250,14 +556,27 @@ static void parse_expression(Parser* parser) {
                 advance(parser);
             }
             
-            set_variable(parser, var_name, value, array);
+            set_variable_owned(parser, var_name, value, array);
             free(var_name);
-            free(value);
             
             if (current_token(parser).type == TOKEN_SEMICOLON) {
                 advance(parser);
             }
         }
+    } else if (token.type == TOKEN_IDENTIFIER) {
+        Variable result;
+        parse_call(parser, &result);
+        release_value(parser, &result);
+        
+        if (current_token(parser).type == TOKEN_SEMICOLON) {
+            advance(parser);
+        }
+    } else if (token.type == TOKEN_INLINE_HTML) {
+        emit(parser, token.value, token.length);
+        advance(parser);
+    } else if (token.type == TOKEN_INCLUDE || token.type == TOKEN_INCLUDE_ONCE || 
+               token.type == TOKEN_REQUIRE || token.type == TOKEN_REQUIRE_ONCE) {
+        parse_include(parser);
     } else if (token.type == TOKEN_IF) {
         advance(parser);
         if (current_token(parser).type == TOKEN_OPEN_PAREN) {
@@ -357,7 +676,8 @@ static void parse_expression(Parser* parser) {
                         advance(parser);
                         
                         int start_pos = parser->position;
-                        while (evaluate_condition(parser, 
+                        while (!parser->halted && 
+                               evaluate_condition(parser, 
                                                get_variable_value(parser, cond_var), 
                                                cond_op, 
                                                cond_limit)) {
@@ -383,9 +703,14 @@ static void parse_expression(Parser* parser) {
         if (current_token(parser).type == TOKEN_OPEN_PAREN) {
             advance(parser);
             
-            char* array_var = current_token(parser).value;
-            advance(parser);
-            Array* array = get_variable_array(parser, array_var);
+            // Tableau, ou fichier ouvert parcouru ligne par ligne
+            Variable subject;
+            parse_argument(parser, &subject);
+            Array* array = subject.array;
+            char handle[32] = "";
+            if (!array && stream_get(parser, subject.value)) {
+                snprintf(handle, sizeof(handle), "%s", subject.value);
+            }
             
             if (current_token(parser).type == TOKEN_AS) {
                 advance(parser); // Passer "as"
@@ -409,7 +734,7 @@ static void parse_expression(Parser* parser) {
                         
                         if (array) {
                             int start_pos = parser->position;
-                            for (int i = 0; i < array->count; i++) {
+                            for (int i = 0; i < array->count && !parser->halted; i++) {
                                 if (key_var) {
                                     set_variable(parser, key_var, array->items[i].key, NULL);
                                 }
@@ -417,6 +742,30 @@ static void parse_expression(Parser* parser) {
                                 parse_block(parser);
                                 parser->position = start_pos;
                             }
+                        } else if (handle[0]) {
+                            int start_pos = parser->position;
+                            int index = 0;
+                            Stream* stream = stream_get(parser, handle);
+                            unsigned closes = parser->stream_closes;
+                            const char* line;
+                            size_t length;
+                            while (!parser->halted && stream && 
+                                   stream_read_line(stream, &line, &length)) {
+                                if (key_var) {
+                                    char key[32];
+                                    snprintf(key, sizeof(key), "%d", index);
+                                    set_variable(parser, key_var, key, NULL);
+                                }
+                                set_variable_length(parser, value_var, line, length);
+                                parse_block(parser);
+                                parser->position = start_pos;
+                                index++;
+                                // Le corps a pu fermer (ou rouvrir) le fichier
+                                if (parser->stream_closes != closes) {
+                                    stream = stream_get(parser, handle);
+                                    closes = parser->stream_closes;
+                                }
+                            }
                         }
                         int depth = 1;
                         while (depth > 0 && current_token(parser).type != TOKEN_EOF) {
@@ -427,12 +776,19 @@ static void parse_expression(Parser* parser) {
                     }
                 }
             }
+            
+            if (!subject.name && handle[0]) {
+                stream_close(parser, handle);
+            }
+            release_value(parser, &subject);
         }
+    } else {
+        advance(parser); // Token isolé, par exemple le ";" implicite de "?>"
     }
 }
 
 void parser_run(Parser* parser) {
-    while (current_token(parser).type != TOKEN_EOF) {
+    while (!parser->halted && current_token(parser).type != TOKEN_EOF) {
         parse_expression(parser);
     }
 }
\ No newline at end of file
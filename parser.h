@@ -1,11 +1,14 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <stddef.h>
+#include <sys/types.h>
 #include "lexer.h"
 
 typedef struct {
     char* key;   // Peut être NULL pour les tableaux indexés
     char* value;
+    int is_json; // Objet ou tableau imbriqué gardé en texte par json_decode
 } ArrayItem;
 
 typedef struct {
@@ -20,16 +23,44 @@ typedef struct {
     Array* array; // Pour les tableaux, NULL si ce n'est pas un tableau
 } Variable;
 
+typedef struct {
+    dev_t device;
+    ino_t inode;
+} IncludedFile;
+
+struct Stream;
+
 typedef struct {
     Lexer* lexer;
     int position;
     Variable* variables;
     int var_count;
     int var_capacity;
+    Array** array_pool;   // Tableaux libérés, réutilisés avec leur capacité
+    int array_pool_count;
+    int array_pool_capacity;
+    char* output;         // Buffer de sortie, NULL pour écrire sur stdout
+    size_t output_size;
+    size_t output_length; // Taille totale produite, même si tronquée
+    struct Stream** streams; // Fichiers ouverts, indexés par "Resource id #N" - 1
+    int stream_count;
+    int stream_capacity;
+    unsigned stream_closes; // Incrémenté à chaque fermeture de fichier
+    const char* filename; // Fichier en cours d'exécution, NULL pour une chaîne
+    IncludedFile* included; // Pour include_once / require_once
+    int included_count;
+    int included_capacity;
+    int halted;           // Erreur fatale : arrêt de l'exécution
 } Parser;
 
 Parser* parser_create(Lexer* lexer);
 void parser_free(Parser* parser);
+void parser_reset(Parser* parser); // Vide les variables sans libérer les buffers
 void parser_run(Parser* parser);
+void parser_set_output(Parser* parser, char* buffer, size_t size);
+void parser_set_variable(Parser* parser, const char* name, const char* value);
+void parser_set_array(Parser* parser, const char* name, Array* array);
+Array* parser_array_create(Parser* parser);
+void parser_array_release(Parser* parser, Array* array);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,1214 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <pthread.h>
+#include "regex.h"
+
+#define MAX_PROGRAM 20000
+
+#define FLAG_ICASE     1
+#define FLAG_MULTILINE 2
+#define FLAG_DOTALL    4
+
+typedef enum {
+    OP_CHAR,
+    OP_ANY,
+    OP_CLASS,
+    OP_SPLIT,      // x prioritaire sur y
+    OP_JMP,
+    OP_SAVE,
+    OP_BOL,        // ^
+    OP_EOL,        // $
+    OP_BEGIN,      // \A
+    OP_END,        // \z
+    OP_END_LINE,   // \Z : fin, ou avant un \n final, même avec l'option m
+    OP_WORD,       // \b
+    OP_NOT_WORD,   // \B
+    OP_MATCH
+} OpCode;
+
+typedef struct {
+    OpCode op;
+    int x;
+    int y;
+} Instruction;
+
+typedef enum {
+    NODE_EMPTY,
+    NODE_CHAR,
+    NODE_ANY,
+    NODE_CLASS,
+    NODE_ASSERT,
+    NODE_CONCAT,
+    NODE_ALT,
+    NODE_GROUP,
+    NODE_REPEAT
+} NodeType;
+
+typedef struct Node {
+    NodeType type;
+    int value;    // Caractère, index de classe, OpCode d'assertion ou numéro de groupe
+    int min;
+    int max;      // -1 : pas de borne
+    int greedy;
+    struct Node* left;
+    struct Node* right;
+} Node;
+
+typedef struct {
+    unsigned int bits[8];
+} CharClass;
+
+struct Regex {
+    char* pattern;
+    Instruction* program;
+    int length;
+    CharClass* classes;
+    int class_count;
+    int group_count;   // Groupe 0 compris
+    int flags;
+    int anchored;
+    char* prefix;      // Littéral obligatoire en tête, pour sauter avec memmem
+    int prefix_length;
+    Regex* hash_next;
+    Regex* lru_prev;
+    Regex* lru_next;
+    int references;
+    int evicted;
+};
+
+typedef struct {
+    const char* source;
+    int position;
+    int end;
+    int flags;
+    int group_count;
+    const char* error;
+    Node** nodes;
+    int node_count;
+    int node_capacity;
+    CharClass* classes;
+    int class_count;
+    int class_capacity;
+} Compiler;
+
+static Node* new_node(Compiler* compiler, NodeType type) {
+    if (compiler->node_count >= compiler->node_capacity) {
+        compiler->node_capacity = compiler->node_capacity ? compiler->node_capacity * 2 : 16;
+        compiler->nodes = realloc(compiler->nodes, sizeof(Node*) * compiler->node_capacity);
+    }
+    Node* node = calloc(1, sizeof(Node));
+    node->type = type;
+    compiler->nodes[compiler->node_count++] = node;
+    return node;
+}
+
+static Node* new_pair(Compiler* compiler, NodeType type, Node* left, Node* right) {
+    Node* node = new_node(compiler, type);
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
+static int new_class(Compiler* compiler) {
+    if (compiler->class_count >= compiler->class_capacity) {
+        compiler->class_capacity = compiler->class_capacity ? compiler->class_capacity * 2 : 4;
+        compiler->classes = realloc(compiler->classes, sizeof(CharClass) * compiler->class_capacity);
+    }
+    memset(&compiler->classes[compiler->class_count], 0, sizeof(CharClass));
+    return compiler->class_count++;
+}
+
+static void class_set(CharClass* cls, int c) {
+    cls->bits[c >> 5] |= 1u << (c & 31);
+}
+
+static int class_has(const CharClass* cls, int c) {
+    return (cls->bits[c >> 5] >> (c & 31)) & 1;
+}
+
+static int is_word_char(int c) {
+    return isalnum(c) || c == '_';
+}
+
+// \d \w \s et leurs négations
+static int add_shorthand(CharClass* cls, char name) {
+    int negate = isupper((unsigned char)name);
+    int (*test)(int);
+    switch (tolower((unsigned char)name)) {
+        case 'd': test = isdigit; break;
+        case 'w': test = is_word_char; break;
+        case 's': test = isspace; break;
+        default: return 0;
+    }
+    for (int c = 0; c < 256; c++) {
+        if ((test(c) != 0) != negate) {
+            class_set(cls, c);
+        }
+    }
+    return 1;
+}
+
+static int escape_char(char c) {
+    switch (c) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case 'e': return 27;
+        case '0': return '\0';
+        default: return (unsigned char)c;
+    }
+}
+
+static int peek(Compiler* compiler) {
+    return compiler->position < compiler->end ?
+           (unsigned char)compiler->source[compiler->position] : -1;
+}
+
+static Node* parse_alternation(Compiler* compiler);
+
+static Node* parse_class(Compiler* compiler) {
+    int index = new_class(compiler);
+    CharClass cls;
+    memset(&cls, 0, sizeof(cls));
+
+    int negate = 0;
+    if (peek(compiler) == '^') {
+        negate = 1;
+        compiler->position++;
+    }
+
+    int first = 1;
+    while (peek(compiler) != -1 && (peek(compiler) != ']' || first)) {
+        first = 0;
+        int low = peek(compiler);
+        compiler->position++;
+        if (low == '\\') {
+            if (peek(compiler) == -1) {
+                break;
+            }
+            char name = compiler->source[compiler->position++];
+            if (add_shorthand(&cls, name)) {
+                continue;
+            }
+            low = escape_char(name);
+        }
+
+        int high = low;
+        if (peek(compiler) == '-' && compiler->position + 1 < compiler->end &&
+            compiler->source[compiler->position + 1] != ']') {
+            compiler->position++;
+            high = (unsigned char)compiler->source[compiler->position++];
+            if (high == '\\' && peek(compiler) != -1) {
+                high = escape_char(compiler->source[compiler->position++]);
+            }
+            if (high < low) {
+                compiler->error = "intervalle invalide dans une classe";
+                return NULL;
+            }
+        }
+        for (int c = low; c <= high; c++) {
+            class_set(&cls, c);
+            if (compiler->flags & FLAG_ICASE) {
+                class_set(&cls, tolower(c));
+                class_set(&cls, toupper(c));
+            }
+        }
+    }
+
+    if (peek(compiler) != ']') {
+        compiler->error = "classe non terminée";
+        return NULL;
+    }
+    compiler->position++;
+
+    if (negate) {
+        for (int i = 0; i < 8; i++) {
+            cls.bits[i] = ~cls.bits[i];
+        }
+    }
+    compiler->classes[index] = cls;
+
+    Node* node = new_node(compiler, NODE_CLASS);
+    node->value = index;
+    return node;
+}
+
+static Node* parse_atom(Compiler* compiler) {
+    int c = peek(compiler);
+    compiler->position++;
+
+    if (c == '(') {
+        int group = -1;
+        if (peek(compiler) == '?') {
+            if (compiler->position + 1 < compiler->end &&
+                compiler->source[compiler->position + 1] == ':') {
+                compiler->position += 2;
+            } else {
+                compiler->error = "type de groupe non supporté";
+                return NULL;
+            }
+        } else {
+            group = compiler->group_count++;
+        }
+
+        Node* child = parse_alternation(compiler);
+        if (!child) {
+            return NULL;
+        }
+        if (peek(compiler) != ')') {
+            compiler->error = "parenthèse non fermée";
+            return NULL;
+        }
+        compiler->position++;
+
+        Node* node = new_pair(compiler, NODE_GROUP, child, NULL);
+        node->value = group;
+        return node;
+    }
+
+    if (c == '[') {
+        return parse_class(compiler);
+    }
+
+    if (c == '.') {
+        return new_node(compiler, NODE_ANY);
+    }
+
+    if (c == '^' || c == '$') {
+        Node* node = new_node(compiler, NODE_ASSERT);
+        node->value = c == '^' ? OP_BOL : OP_EOL;
+        return node;
+    }
+
+    if (c == '\\') {
+        if (peek(compiler) == -1) {
+            compiler->error = "\\ final";
+            return NULL;
+        }
+        char name = compiler->source[compiler->position++];
+
+        if (strchr("AzZbB", name)) {
+            Node* node = new_node(compiler, NODE_ASSERT);
+            node->value = name == 'A' ? OP_BEGIN :
+                          name == 'b' ? OP_WORD :
+                          name == 'B' ? OP_NOT_WORD :
+                          name == 'Z' ? OP_END_LINE : OP_END;
+            return node;
+        }
+        if (isdigit((unsigned char)name) && name != '0') {
+            compiler->error = "références arrière non supportées";
+            return NULL;
+        }
+
+        CharClass cls;
+        memset(&cls, 0, sizeof(cls));
+        if (add_shorthand(&cls, name)) {
+            Node* node = new_node(compiler, NODE_CLASS);
+            node->value = new_class(compiler);
+            compiler->classes[node->value] = cls;
+            return node;
+        }
+
+        Node* node = new_node(compiler, NODE_CHAR);
+        node->value = escape_char(name);
+        return node;
+    }
+
+    if (c == '*' || c == '+' || c == '?') {
+        compiler->error = "quantificateur sans opérande";
+        return NULL;
+    }
+
+    Node* node = new_node(compiler, NODE_CHAR);
+    node->value = c;
+    return node;
+}
+
+// {n}, {n,} ou {n,m} ; sinon "{" est un caractère littéral
+static int parse_braces(Compiler* compiler, int* min, int* max) {
+    int position = compiler->position + 1;
+    int low = 0, high;
+    int digits = 0;
+    while (position < compiler->end && isdigit((unsigned char)compiler->source[position])) {
+        low = low * 10 + (compiler->source[position++] - '0');
+        digits++;
+    }
+    if (!digits || low > 1000) {
+        return 0;
+    }
+
+    high = low;
+    if (position < compiler->end && compiler->source[position] == ',') {
+        position++;
+        high = -1;
+        if (position < compiler->end && isdigit((unsigned char)compiler->source[position])) {
+            high = 0;
+            while (position < compiler->end && isdigit((unsigned char)compiler->source[position])) {
+                high = high * 10 + (compiler->source[position++] - '0');
+            }
+            if (high < low || high > 1000) {
+                return 0;
+            }
+        }
+    }
+    if (position >= compiler->end || compiler->source[position] != '}') {
+        return 0;
+    }
+
+    compiler->position = position + 1;
+    *min = low;
+    *max = high;
+    return 1;
+}
+
+static Node* parse_repeat(Compiler* compiler) {
+    Node* atom = parse_atom(compiler);
+
+    while (atom) {
+        int c = peek(compiler);
+        int min, max;
+        if (c == '*') {
+            min = 0; max = -1;
+            compiler->position++;
+        } else if (c == '+') {
+            min = 1; max = -1;
+            compiler->position++;
+        } else if (c == '?') {
+            min = 0; max = 1;
+            compiler->position++;
+        } else if (c != '{' || !parse_braces(compiler, &min, &max)) {
+            break;
+        }
+
+        if (atom->type == NODE_ASSERT) {
+            compiler->error = "quantificateur sur une assertion";
+            return NULL;
+        }
+
+        Node* node = new_pair(compiler, NODE_REPEAT, atom, NULL);
+        node->min = min;
+        node->max = max;
+        node->greedy = 1;
+        if (peek(compiler) == '?') {
+            node->greedy = 0;
+            compiler->position++;
+        } else if (peek(compiler) == '+') {
+            compiler->error = "quantificateurs possessifs non supportés";
+            return NULL;
+        }
+        atom = node;
+    }
+    return atom;
+}
+
+static Node* parse_concatenation(Compiler* compiler) {
+    Node* node = new_node(compiler, NODE_EMPTY);
+    while (peek(compiler) != -1 && peek(compiler) != '|' && peek(compiler) != ')') {
+        Node* next = parse_repeat(compiler);
+        if (!next) {
+            return NULL;
+        }
+        node = node->type == NODE_EMPTY ? next : new_pair(compiler, NODE_CONCAT, node, next);
+    }
+    return node;
+}
+
+static Node* parse_alternation(Compiler* compiler) {
+    Node* node = parse_concatenation(compiler);
+    while (node && peek(compiler) == '|') {
+        compiler->position++;
+        Node* right = parse_concatenation(compiler);
+        if (!right) {
+            return NULL;
+        }
+        node = new_pair(compiler, NODE_ALT, node, right);
+    }
+    return node;
+}
+
+static int emit(Regex* regex, OpCode op, int x, int y) {
+    if (regex->length >= MAX_PROGRAM) {
+        return -1;
+    }
+    regex->program[regex->length].op = op;
+    regex->program[regex->length].x = x;
+    regex->program[regex->length].y = y;
+    return regex->length++;
+}
+
+static int compile_node(Regex* regex, Compiler* compiler, Node* node) {
+    if (regex->length >= MAX_PROGRAM) {
+        return -1;
+    }
+
+    switch (node->type) {
+        case NODE_EMPTY:
+            return 0;
+        case NODE_CHAR:
+            if ((regex->flags & FLAG_ICASE) && isalpha(node->value)) {
+                int index = new_class(compiler);
+                class_set(&compiler->classes[index], tolower(node->value));
+                class_set(&compiler->classes[index], toupper(node->value));
+                return emit(regex, OP_CLASS, index, 0) < 0 ? -1 : 0;
+            }
+            return emit(regex, OP_CHAR, node->value, 0) < 0 ? -1 : 0;
+        case NODE_ANY:
+            return emit(regex, OP_ANY, 0, 0) < 0 ? -1 : 0;
+        case NODE_CLASS:
+            return emit(regex, OP_CLASS, node->value, 0) < 0 ? -1 : 0;
+        case NODE_ASSERT:
+            return emit(regex, (OpCode)node->value, 0, 0) < 0 ? -1 : 0;
+        case NODE_CONCAT:
+            if (compile_node(regex, compiler, node->left) < 0) {
+                return -1;
+            }
+            return compile_node(regex, compiler, node->right);
+        case NODE_ALT: {
+            int split = emit(regex, OP_SPLIT, 0, 0);
+            if (split < 0) {
+                return -1;
+            }
+            regex->program[split].x = regex->length;
+            if (compile_node(regex, compiler, node->left) < 0) {
+                return -1;
+            }
+            int jump = emit(regex, OP_JMP, 0, 0);
+            if (jump < 0) {
+                return -1;
+            }
+            regex->program[split].y = regex->length;
+            if (compile_node(regex, compiler, node->right) < 0) {
+                return -1;
+            }
+            regex->program[jump].x = regex->length;
+            return 0;
+        }
+        case NODE_GROUP:
+            if (node->value < 0) {
+                return compile_node(regex, compiler, node->left);
+            }
+            if (emit(regex, OP_SAVE, node->value * 2, 0) < 0 ||
+                compile_node(regex, compiler, node->left) < 0) {
+                return -1;
+            }
+            return emit(regex, OP_SAVE, node->value * 2 + 1, 0) < 0 ? -1 : 0;
+        case NODE_REPEAT: {
+            for (int i = 0; i < node->min; i++) {
+                if (compile_node(regex, compiler, node->left) < 0) {
+                    return -1;
+                }
+            }
+
+            if (node->max == -1) {
+                int split = emit(regex, OP_SPLIT, 0, 0);
+                if (split < 0 || compile_node(regex, compiler, node->left) < 0 ||
+                    emit(regex, OP_JMP, split, 0) < 0) {
+                    return -1;
+                }
+                regex->program[split].x = node->greedy ? split + 1 : regex->length;
+                regex->program[split].y = node->greedy ? regex->length : split + 1;
+                return 0;
+            }
+
+            // Copies optionnelles : chaque SPLIT saute à la fin commune
+            int optional = node->max - node->min;
+            int* splits = malloc(sizeof(int) * (optional > 0 ? optional : 1));
+            for (int i = 0; i < optional; i++) {
+                splits[i] = emit(regex, OP_SPLIT, 0, 0);
+                if (splits[i] < 0 || compile_node(regex, compiler, node->left) < 0) {
+                    free(splits);
+                    return -1;
+                }
+            }
+            for (int i = 0; i < optional; i++) {
+                regex->program[splits[i]].x = node->greedy ? splits[i] + 1 : regex->length;
+                regex->program[splits[i]].y = node->greedy ? regex->length : splits[i] + 1;
+            }
+            free(splits);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Littéral en tête de l'expression, hors alternative et quantificateur
+static int collect_prefix(Node* node, char* prefix, int* length) {
+    if (node->type == NODE_CHAR) {
+        prefix[(*length)++] = (char)node->value;
+        return 1;
+    }
+    if (node->type == NODE_CONCAT) {
+        return collect_prefix(node->left, prefix, length) &&
+               collect_prefix(node->right, prefix, length);
+    }
+    return 0;
+}
+
+static void regex_free(Regex* regex) {
+    free(regex->pattern);
+    free(regex->program);
+    free(regex->classes);
+    free(regex->prefix);
+    free(regex);
+}
+
+static Regex* regex_compile(const char* pattern, const char** error) {
+    const char* start = pattern;
+    while (isspace((unsigned char)*start)) {
+        start++;
+    }
+
+    char open = *start;
+    if (!open || isalnum((unsigned char)open) || open == '\\') {
+        *error = "délimiteur invalide";
+        return NULL;
+    }
+    char close = open == '(' ? ')' : open == '{' ? '}' : open == '[' ? ']' :
+                 open == '<' ? '>' : open;
+
+    const char* end = start + 1;
+    int depth = 1;
+    while (*end) {
+        if (*end == '\\' && end[1]) {
+            end += 2;
+            continue;
+        }
+        if (*end == close && --depth == 0) {
+            break;
+        }
+        if (*end == open && open != close) {
+            depth++;
+        }
+        end++;
+    }
+    if (*end != close) {
+        *error = "délimiteur de fin manquant";
+        return NULL;
+    }
+
+    int flags = 0;
+    for (const char* flag = end + 1; *flag; flag++) {
+        switch (*flag) {
+            case 'i': flags |= FLAG_ICASE; break;
+            case 'm': flags |= FLAG_MULTILINE; break;
+            case 's': flags |= FLAG_DOTALL; break;
+            case 'u': break;
+            case '\n': case ' ': break;
+            default:
+                *error = "option inconnue";
+                return NULL;
+        }
+    }
+
+    Compiler compiler;
+    memset(&compiler, 0, sizeof(compiler));
+    compiler.source = start + 1;
+    compiler.end = end - (start + 1);
+    compiler.flags = flags;
+    compiler.group_count = 1;
+
+    Node* root = parse_alternation(&compiler);
+    if (root && compiler.position < compiler.end) {
+        compiler.error = "parenthèse fermante en trop";
+        root = NULL;
+    }
+
+    Regex* regex = NULL;
+    if (root) {
+        regex = calloc(1, sizeof(Regex));
+        regex->pattern = strdup(pattern);
+        regex->flags = flags;
+        regex->group_count = compiler.group_count;
+        regex->program = malloc(sizeof(Instruction) * MAX_PROGRAM);
+
+        if (emit(regex, OP_SAVE, 0, 0) < 0 || compile_node(regex, &compiler, root) < 0 ||
+            emit(regex, OP_SAVE, 1, 0) < 0 || emit(regex, OP_MATCH, 0, 0) < 0) {
+            compiler.error = "expression trop grande";
+            regex_free(regex);
+            regex = NULL;
+        } else {
+            regex->program = realloc(regex->program, sizeof(Instruction) * regex->length);
+            regex->classes = compiler.classes;
+            regex->class_count = compiler.class_count;
+            compiler.classes = NULL;
+
+            regex->anchored = regex->length > 1 && (regex->program[1].op == OP_BEGIN ||
+                              (regex->program[1].op == OP_BOL && !(flags & FLAG_MULTILINE)));
+            if (!(flags & FLAG_ICASE)) {
+                regex->prefix = malloc(compiler.end + 1);
+                collect_prefix(root, regex->prefix, &regex->prefix_length);
+            }
+        }
+    }
+
+    for (int i = 0; i < compiler.node_count; i++) {
+        free(compiler.nodes[i]);
+    }
+    free(compiler.nodes);
+    free(compiler.classes);
+    *error = compiler.error;
+    return regex;
+}
+
+int regex_group_count(const Regex* regex) {
+    return regex->group_count;
+}
+
+// Listes de threads de la machine de Pike, réutilisées d'un appel à l'autre
+typedef struct {
+    int pc;
+    int* captures;
+} Thread;
+
+typedef struct {
+    Thread* threads;
+    int* slab;
+    int count;
+} ThreadList;
+
+typedef struct {
+    ThreadList lists[2];
+    int* marks;
+    int program_capacity;
+    int capture_capacity;
+    int generation;
+} Scratch;
+
+// Une zone par thread, libérée à la sortie du thread
+static pthread_key_t scratch_key;
+static pthread_once_t scratch_once = PTHREAD_ONCE_INIT;
+
+static void free_scratch(void* data) {
+    Scratch* scratch = data;
+    if (!scratch) {
+        return;
+    }
+    for (int i = 0; i < 2; i++) {
+        free(scratch->lists[i].threads);
+        free(scratch->lists[i].slab);
+    }
+    free(scratch->marks);
+    free(scratch);
+}
+
+static void create_scratch_key(void) {
+    pthread_key_create(&scratch_key, free_scratch);
+}
+
+static Scratch* prepare_scratch(int program_length, int capture_count) {
+    pthread_once(&scratch_once, create_scratch_key);
+    Scratch* scratch = pthread_getspecific(scratch_key);
+    if (!scratch) {
+        scratch = calloc(1, sizeof(Scratch));
+        pthread_setspecific(scratch_key, scratch);
+    }
+    
+    if (program_length > scratch->program_capacity || capture_count > scratch->capture_capacity) {
+        if (program_length > scratch->program_capacity) {
+            scratch->program_capacity = program_length;
+        }
+        if (capture_count > scratch->capture_capacity) {
+            scratch->capture_capacity = capture_count;
+        }
+        for (int i = 0; i < 2; i++) {
+            scratch->lists[i].threads = realloc(scratch->lists[i].threads,
+                                                sizeof(Thread) * scratch->program_capacity);
+            scratch->lists[i].slab = realloc(scratch->lists[i].slab, sizeof(int) *
+                                             scratch->program_capacity * scratch->capture_capacity);
+        }
+        scratch->marks = realloc(scratch->marks, sizeof(int) * scratch->program_capacity);
+        memset(scratch->marks, 0, sizeof(int) * scratch->program_capacity);
+        scratch->generation = 0;
+    }
+    if (scratch->generation > INT_MAX - 2) {
+        memset(scratch->marks, 0, sizeof(int) * scratch->program_capacity);
+        scratch->generation = 0;
+    }
+    return scratch;
+}
+
+typedef struct {
+    const Regex* regex;
+    const unsigned char* subject;
+    int length;
+    int capture_count;
+    Scratch* scratch;
+} Machine;
+
+static int assertion_holds(const Machine* machine, OpCode op, int sp) {
+    const unsigned char* s = machine->subject;
+    int multiline = machine->regex->flags & FLAG_MULTILINE;
+    switch (op) {
+        case OP_BOL:
+            return sp == 0 || (multiline && s[sp - 1] == '\n');
+        case OP_EOL:
+            return sp == machine->length ||
+                   (s[sp] == '\n' && (multiline || sp == machine->length - 1));
+        case OP_BEGIN:
+            return sp == 0;
+        case OP_END:
+            return sp == machine->length;
+        case OP_END_LINE:
+            return sp == machine->length || (sp == machine->length - 1 && s[sp] == '\n');
+        case OP_WORD:
+        case OP_NOT_WORD: {
+            int before = sp > 0 && is_word_char(s[sp - 1]);
+            int after = sp < machine->length && is_word_char(s[sp]);
+            return (before != after) == (op == OP_WORD);
+        }
+        default:
+            return 0;
+    }
+}
+
+static void add_thread(const Machine* machine, ThreadList* list, int pc, int* captures, int sp) {
+    Scratch* scratch = machine->scratch;
+    if (scratch->marks[pc] == scratch->generation) {
+        return;
+    }
+    scratch->marks[pc] = scratch->generation;
+
+    const Instruction* instruction = &machine->regex->program[pc];
+    switch (instruction->op) {
+        case OP_JMP:
+            add_thread(machine, list, instruction->x, captures, sp);
+            break;
+        case OP_SPLIT:
+            add_thread(machine, list, instruction->x, captures, sp);
+            add_thread(machine, list, instruction->y, captures, sp);
+            break;
+        case OP_SAVE: {
+            int saved = captures[instruction->x];
+            captures[instruction->x] = sp;
+            add_thread(machine, list, pc + 1, captures, sp);
+            captures[instruction->x] = saved;
+            break;
+        }
+        case OP_BOL:
+        case OP_EOL:
+        case OP_BEGIN:
+        case OP_END:
+        case OP_END_LINE:
+        case OP_WORD:
+        case OP_NOT_WORD:
+            if (assertion_holds(machine, instruction->op, sp)) {
+                add_thread(machine, list, pc + 1, captures, sp);
+            }
+            break;
+        default: {
+            Thread* thread = &list->threads[list->count];
+            thread->pc = pc;
+            thread->captures = list->slab + list->count * machine->capture_count;
+            memcpy(thread->captures, captures, sizeof(int) * machine->capture_count);
+            list->count++;
+            break;
+        }
+    }
+}
+
+// Cherche la première correspondance à partir de start. captures reçoit
+// 2 * regex_group_count() positions, -1 pour un groupe non capturé.
+int regex_exec(Regex* regex, const char* subject, int length, int start, int* captures) {
+    Machine machine = {regex, (const unsigned char*)subject, length, regex->group_count * 2, NULL};
+    Scratch* scratch = machine.scratch = prepare_scratch(regex->length, machine.capture_count);
+
+    int initial[machine.capture_count];
+    ThreadList* current = &scratch->lists[0];
+    ThreadList* next = &scratch->lists[1];
+    current->count = 0;
+    scratch->generation++;
+
+    int matched = 0;
+    for (int sp = start; sp <= length; sp++) {
+        if (!matched && (!regex->anchored || sp == 0)) {
+            if (current->count == 0 && regex->prefix_length > 0) {
+                const char* found = memmem(subject + sp, length - sp,
+                                           regex->prefix, regex->prefix_length);
+                if (!found) {
+                    break;
+                }
+                sp = found - subject;
+            }
+            for (int i = 0; i < machine.capture_count; i++) {
+                initial[i] = -1;
+            }
+            add_thread(&machine, current, 0, initial, sp);
+        }
+        if (current->count == 0) {
+            if (matched || regex->anchored) {
+                break;
+            }
+            scratch->generation++;
+            continue;
+        }
+
+        scratch->generation++;
+        next->count = 0;
+        for (int i = 0; i < current->count; i++) {
+            Thread* thread = &current->threads[i];
+            const Instruction* instruction = &regex->program[thread->pc];
+            int c = sp < length ? machine.subject[sp] : -1;
+            int step = 0;
+
+            switch (instruction->op) {
+                case OP_CHAR:
+                    step = c == instruction->x;
+                    break;
+                case OP_ANY:
+                    step = c != -1 && (c != '\n' || (regex->flags & FLAG_DOTALL));
+                    break;
+                case OP_CLASS:
+                    step = c != -1 && class_has(&regex->classes[instruction->x], c);
+                    break;
+                case OP_MATCH:
+                    matched = 1;
+                    memcpy(captures, thread->captures, sizeof(int) * machine.capture_count);
+                    i = current->count;  // Les threads moins prioritaires sont abandonnés
+                    break;
+                default:
+                    break;
+            }
+            if (step) {
+                add_thread(&machine, next, thread->pc + 1, thread->captures, sp + 1);
+            }
+        }
+
+        ThreadList* swap = current;
+        current = next;
+        next = swap;
+    }
+    return matched;
+}
+
+// Cache LRU des expressions compilées, partagé par tout le processus.
+// Une expression évincée reste valide jusqu'à son dernier regex_release().
+static Regex* cache_buckets[REGEX_CACHE_SIZE];
+static Regex* lru_head = NULL;
+static Regex* lru_tail = NULL;
+static int cache_count = 0;
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int hash_pattern(const char* pattern) {
+    unsigned int hash = 2166136261u;
+    while (*pattern) {
+        hash ^= (unsigned char)*pattern++;
+        hash *= 16777619u;
+    }
+    return hash % REGEX_CACHE_SIZE;
+}
+
+static void lru_unlink(Regex* regex) {
+    if (regex->lru_prev) regex->lru_prev->lru_next = regex->lru_next;
+    else lru_head = regex->lru_next;
+    if (regex->lru_next) regex->lru_next->lru_prev = regex->lru_prev;
+    else lru_tail = regex->lru_prev;
+    regex->lru_prev = regex->lru_next = NULL;
+}
+
+static void lru_push_front(Regex* regex) {
+    regex->lru_prev = NULL;
+    regex->lru_next = lru_head;
+    if (lru_head) lru_head->lru_prev = regex;
+    lru_head = regex;
+    if (!lru_tail) lru_tail = regex;
+}
+
+static void cache_remove(Regex* regex) {
+    Regex** link = &cache_buckets[hash_pattern(regex->pattern)];
+    while (*link != regex) {
+        link = &(*link)->hash_next;
+    }
+    *link = regex->hash_next;
+    lru_unlink(regex);
+    cache_count--;
+
+    regex->evicted = 1;
+    if (regex->references == 0) {
+        regex_free(regex);
+    }
+}
+
+Regex* regex_acquire(const char* pattern) {
+    unsigned int index = hash_pattern(pattern);
+
+    pthread_mutex_lock(&cache_mutex);
+    Regex* regex = cache_buckets[index];
+    while (regex && strcmp(regex->pattern, pattern) != 0) {
+        regex = regex->hash_next;
+    }
+    if (regex) {
+        lru_unlink(regex);
+        lru_push_front(regex);
+        regex->references++;
+        pthread_mutex_unlock(&cache_mutex);
+        return regex;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+
+    const char* error = NULL;
+    regex = regex_compile(pattern, &error);
+    if (!regex) {
+        fprintf(stderr, "Avertissement: expression régulière invalide %s : %s\n", pattern, error);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&cache_mutex);
+    Regex* existing = cache_buckets[index];
+    while (existing && strcmp(existing->pattern, pattern) != 0) {
+        existing = existing->hash_next;
+    }
+    if (existing) {
+        // Compilée en même temps par un autre thread
+        regex_free(regex);
+        regex = existing;
+        lru_unlink(regex);
+    } else {
+        if (cache_count >= REGEX_CACHE_SIZE) {
+            cache_remove(lru_tail);
+        }
+        regex->hash_next = cache_buckets[index];
+        cache_buckets[index] = regex;
+        cache_count++;
+    }
+    lru_push_front(regex);
+    regex->references++;
+    pthread_mutex_unlock(&cache_mutex);
+    return regex;
+}
+
+void regex_release(Regex* regex) {
+    pthread_mutex_lock(&cache_mutex);
+    if (--regex->references == 0 && regex->evicted) {
+        regex_free(regex);
+    }
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+void regex_cache_clear(void) {
+    pthread_mutex_lock(&cache_mutex);
+    while (lru_head) {
+        cache_remove(lru_head);
+    }
+    pthread_mutex_unlock(&cache_mutex);
+    
+    // Le thread appelant ne passe pas forcément par pthread_exit
+    pthread_once(&scratch_once, create_scratch_key);
+    free_scratch(pthread_getspecific(scratch_key));
+    pthread_setspecific(scratch_key, NULL);
+}
+
+static char* copy_range(const char* text, int start, int end) {
+    if (start < 0 || end < start) {
+        return strdup("");
+    }
+    char* copy = malloc(end - start + 1);
+    memcpy(copy, text + start, end - start);
+    copy[end - start] = '\0';
+    return copy;
+}
+
+static void array_append(Parser* parser, Array* array, char* value) {
+    (void)parser;
+    if (array->count >= array->capacity) {
+        array->capacity *= 2;
+        array->items = realloc(array->items, sizeof(ArrayItem) * array->capacity);
+    }
+    array->items[array->count].key = NULL;
+    array->items[array->count].value = value;
+    array->items[array->count].is_json = 0;
+    array->count++;
+}
+
+static char* format_count(int count) {
+    char* value = malloc(16);
+    snprintf(value, 16, "%d", count);
+    return value;
+}
+
+int builtin_preg_match(Parser* parser, int argc, Variable* args, Variable* result) {
+    if (argc < 2 || !args[0].value) {
+        return -1;
+    }
+    Regex* regex = regex_acquire(args[0].value);
+    if (!regex) {
+        return 0;
+    }
+
+    const char* subject = args[1].value ? args[1].value : "";
+    int captures[regex->group_count * 2];
+    int matched = regex_exec(regex, subject, strlen(subject), 0, captures);
+
+    if (argc > 2 && args[2].name) {
+        Array* matches = parser_array_create(parser);
+        if (matched) {
+            for (int i = 0; i < regex->group_count; i++) {
+                array_append(parser, matches, copy_range(subject, captures[2 * i], captures[2 * i + 1]));
+            }
+        }
+        parser_set_array(parser, args[2].name, matches);
+    }
+    regex_release(regex);
+
+    result->value = format_count(matched);
+    return 0;
+}
+
+// $matches reçoit la liste plate des correspondances complètes : les
+// tableaux de l'interpréteur ne peuvent pas contenir de sous-tableaux.
+int builtin_preg_match_all(Parser* parser, int argc, Variable* args, Variable* result) {
+    if (argc < 2 || !args[0].value) {
+        return -1;
+    }
+    Regex* regex = regex_acquire(args[0].value);
+    if (!regex) {
+        return 0;
+    }
+
+    const char* subject = args[1].value ? args[1].value : "";
+    int length = strlen(subject);
+    int captures[regex->group_count * 2];
+    Array* matches = argc > 2 && args[2].name ? parser_array_create(parser) : NULL;
+    int count = 0;
+
+    int position = 0;
+    while (position <= length && regex_exec(regex, subject, length, position, captures)) {
+        count++;
+        if (matches) {
+            array_append(parser, matches, copy_range(subject, captures[0], captures[1]));
+        }
+        position = captures[1] > captures[0] ? captures[1] : captures[1] + 1;
+    }
+
+    if (matches) {
+        parser_set_array(parser, args[2].name, matches);
+    }
+    regex_release(regex);
+
+    result->value = format_count(count);
+    return 0;
+}
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+static void buffer_append(Buffer* buffer, const char* data, size_t length) {
+    if (buffer->length + length + 1 > buffer->capacity) {
+        while (buffer->length + length + 1 > buffer->capacity) {
+            buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 64;
+        }
+        buffer->data = realloc(buffer->data, buffer->capacity);
+    }
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+}
+
+// Références $n, ${n} et \n dans la chaîne de remplacement
+static void append_replacement(Buffer* buffer, const char* replacement, const char* subject,
+                               const int* captures, int group_count) {
+    const char* p = replacement;
+    while (*p) {
+        if ((*p == '$' || *p == '\\') && (isdigit((unsigned char)p[1]) ||
+                                          (*p == '$' && p[1] == '{'))) {
+            const char* q = p + 1;
+            int braced = *q == '{';
+            if (braced) {
+                q++;
+            }
+            int group = 0, digits = 0;
+            while (isdigit((unsigned char)*q) && digits < 2) {
+                group = group * 10 + (*q++ - '0');
+                digits++;
+            }
+            if (digits && (!braced || *q == '}')) {
+                if (braced) {
+                    q++;
+                }
+                if (group < group_count && captures[2 * group] >= 0) {
+                    buffer_append(buffer, subject + captures[2 * group],
+                                  captures[2 * group + 1] - captures[2 * group]);
+                }
+                p = q;
+                continue;
+            }
+        }
+        buffer_append(buffer, p, 1);
+        p++;
+    }
+}
+
+int builtin_preg_replace(Parser* parser, int argc, Variable* args, Variable* result) {
+    (void)parser;
+    if (argc < 3 || !args[0].value) {
+        return -1;
+    }
+    Regex* regex = regex_acquire(args[0].value);
+    if (!regex) {
+        return 0;
+    }
+
+    const char* replacement = args[1].value ? args[1].value : "";
+    const char* subject = args[2].value ? args[2].value : "";
+    int limit = argc > 3 && args[3].value ? atoi(args[3].value) : -1;
+    int length = strlen(subject);
+    int captures[regex->group_count * 2];
+    Buffer output = {NULL, 0, 0};
+    buffer_append(&output, "", 0);
+
+    int position = 0;
+    int copied = 0;
+    while (limit != 0 && position <= length &&
+           regex_exec(regex, subject, length, position, captures)) {
+        buffer_append(&output, subject + copied, captures[0] - copied);
+        append_replacement(&output, replacement, subject, captures, regex->group_count);
+        copied = captures[1];
+        position = captures[1] > captures[0] ? captures[1] : captures[1] + 1;
+        if (limit > 0) {
+            limit--;
+        }
+    }
+    buffer_append(&output, subject + copied, length - copied);
+    regex_release(regex);
+
+    result->value = output.data;
+    return 0;
+}
+
+int builtin_preg_split(Parser* parser, int argc, Variable* args, Variable* result) {
+    if (argc < 2 || !args[0].value) {
+        return -1;
+    }
+    Regex* regex = regex_acquire(args[0].value);
+    if (!regex) {
+        return 0;
+    }
+
+    const char* subject = args[1].value ? args[1].value : "";
+    int limit = argc > 2 && args[2].value ? atoi(args[2].value) : -1;
+    int length = strlen(subject);
+    int captures[regex->group_count * 2];
+    Array* pieces = parser_array_create(parser);
+
+    int position = 0;
+    int last = 0;
+    while ((limit <= 0 || pieces->count < limit - 1) && position <= length &&
+           regex_exec(regex, subject, length, position, captures)) {
+        array_append(parser, pieces, copy_range(subject, last, captures[0]));
+        last = captures[1];
+        position = captures[1] > captures[0] ? captures[1] : captures[1] + 1;
+    }
+    array_append(parser, pieces, copy_range(subject, last, length));
+    regex_release(regex);
+
+    result->array = pieces;
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef REGEX_H
+#define REGEX_H
+
+#include "parser.h"
+
+#define REGEX_CACHE_SIZE 256
+
+// Expression compilée pour une machine de Pike : temps linéaire dans la
+// taille du sujet, sans retour arrière. Partagée via un cache LRU.
+typedef struct Regex Regex;
+
+Regex* regex_acquire(const char* pattern);
+void regex_release(Regex* regex);
+int regex_group_count(const Regex* regex);
+int regex_exec(Regex* regex, const char* subject, int length, int start, int* captures);
+// Vide le cache et libère la zone de travail du thread appelant
+void regex_cache_clear(void);
+
+int builtin_preg_match(Parser* parser, int argc, Variable* args, Variable* result);
+int builtin_preg_match_all(Parser* parser, int argc, Variable* args, Variable* result);
+int builtin_preg_replace(Parser* parser, int argc, Variable* args, Variable* result);
+int builtin_preg_split(Parser* parser, int argc, Variable* args, Variable* result);
+
+#endif
@@ -0,0 +1,336 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "stream.h"
+
+#define HANDLE_PREFIX "Resource id #"
+#define HANDLE_PREFIX_LENGTH (sizeof(HANDLE_PREFIX) - 1)
+
+static int register_stream(Parser* parser, Stream* stream) {
+    for (int i = 0; i < parser->stream_count; i++) {
+        if (!parser->streams[i]) {
+            parser->streams[i] = stream;
+            return i + 1;
+        }
+    }
+    
+    if (parser->stream_count >= parser->stream_capacity) {
+        parser->stream_capacity = parser->stream_capacity ? parser->stream_capacity * 2 : 4;
+        parser->streams = realloc(parser->streams, sizeof(Stream*) * parser->stream_capacity);
+    }
+    parser->streams[parser->stream_count++] = stream;
+    return parser->stream_count;
+}
+
+int stream_open(Parser* parser, const char* path, const char* mode) {
+    int flags;
+    if (mode[0] == 'r' && !strchr(mode, '+')) {
+        flags = O_RDONLY;
+    } else if (mode[0] == 'w' && !strchr(mode, '+')) {
+        flags = O_WRONLY | O_CREAT | O_TRUNC;
+    } else if (mode[0] == 'a' && !strchr(mode, '+')) {
+        flags = O_WRONLY | O_CREAT | O_APPEND;
+    } else {
+        fprintf(stderr, "Erreur: mode d'ouverture non supporté: %s\n", mode);
+        return 0;
+    }
+    
+    int fd = open(path, flags, 0644);
+    if (fd < 0) {
+        perror("Erreur lors de l'ouverture du fichier");
+        return 0;
+    }
+    
+    Stream* stream = malloc(sizeof(Stream));
+    stream->fd = fd;
+    stream->writable = flags != O_RDONLY;
+    stream->map = NULL;
+    stream->map_size = 0;
+    stream->buffer = NULL;
+    stream->buffer_capacity = 0;
+    stream->start = 0;
+    stream->end = 0;
+    stream->eof = 0;
+    
+    // Lecture d'un fichier régulier : on le mappe en entier, les lignes
+    // sont alors des tranches de la projection, sans copie.
+    struct stat st;
+    if (!stream->writable && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            stream->map = map;
+            stream->map_size = st.st_size;
+        }
+    }
+    
+    if (!stream->map) {
+        stream->buffer_capacity = STREAM_BUFFER_SIZE;
+        stream->buffer = malloc(stream->buffer_capacity);
+    }
+    
+    return register_stream(parser, stream);
+}
+
+// Appelé à chaque fgets/fwrite : pas de sscanf
+static int stream_id(const char* handle) {
+    if (!handle || strncmp(handle, HANDLE_PREFIX, HANDLE_PREFIX_LENGTH) != 0) {
+        return 0;
+    }
+    return atoi(handle + HANDLE_PREFIX_LENGTH);
+}
+
+Stream* stream_get(Parser* parser, const char* handle) {
+    int id = stream_id(handle);
+    if (id <= 0 || id > parser->stream_count) {
+        return NULL;
+    }
+    return parser->streams[id - 1];
+}
+
+// La ligne retournée (avec son '\n') reste valide jusqu'au prochain appel.
+int stream_read_line(Stream* stream, const char** line, size_t* length) {
+    if (stream->writable) {
+        return 0;
+    }
+    
+    if (stream->map) {
+        if (stream->start >= stream->map_size) {
+            stream->eof = 1;
+            return 0;
+        }
+        const char* begin = stream->map + stream->start;
+        const char* newline = memchr(begin, '\n', stream->map_size - stream->start);
+        size_t size = newline ? (size_t)(newline - begin) + 1 : stream->map_size - stream->start;
+        *line = begin;
+        *length = size;
+        stream->start += size;
+        return 1;
+    }
+    
+    size_t scanned = stream->start;
+    while (1) {
+        char* newline = memchr(stream->buffer + scanned, '\n', stream->end - scanned);
+        if (newline) {
+            *line = stream->buffer + stream->start;
+            *length = newline - *line + 1;
+            stream->start += *length;
+            return 1;
+        }
+        scanned = stream->end;
+        
+        if (stream->eof) {
+            if (stream->start < stream->end) {
+                *line = stream->buffer + stream->start;
+                *length = stream->end - stream->start;
+                stream->start = stream->end;
+                return 1;
+            }
+            return 0;
+        }
+        
+        if (stream->start > 0) {
+            memmove(stream->buffer, stream->buffer + stream->start, stream->end - stream->start);
+            stream->end -= stream->start;
+            scanned -= stream->start;
+            stream->start = 0;
+        }
+        if (stream->end == stream->buffer_capacity) {
+            stream->buffer_capacity *= 2;
+            stream->buffer = realloc(stream->buffer, stream->buffer_capacity);
+        }
+        
+        ssize_t count = read(stream->fd, stream->buffer + stream->end, 
+                             stream->buffer_capacity - stream->end);
+        if (count <= 0) {
+            stream->eof = 1;
+        } else {
+            stream->end += count;
+        }
+    }
+}
+
+static int stream_flush(Stream* stream) {
+    size_t written = 0;
+    while (written < stream->end) {
+        ssize_t count = write(stream->fd, stream->buffer + written, stream->end - written);
+        if (count <= 0) {
+            stream->end = 0;
+            return -1;
+        }
+        written += count;
+    }
+    stream->end = 0;
+    return 0;
+}
+
+size_t stream_write(Stream* stream, const char* data, size_t length) {
+    if (!stream->writable) {
+        return 0;
+    }
+    
+    if (stream->end + length > stream->buffer_capacity && stream_flush(stream) != 0) {
+        return 0;
+    }
+    
+    if (length >= stream->buffer_capacity) {
+        size_t written = 0;
+        while (written < length) {
+            ssize_t count = write(stream->fd, data + written, length - written);
+            if (count <= 0) {
+                break;
+            }
+            written += count;
+        }
+        return written;
+    }
+    
+    memcpy(stream->buffer + stream->end, data, length);
+    stream->end += length;
+    return length;
+}
+
+static void close_stream(Parser* parser, int id) {
+    if (id <= 0 || id > parser->stream_count || !parser->streams[id - 1]) {
+        return;
+    }
+    
+    Stream* stream = parser->streams[id - 1];
+    if (stream->writable) {
+        stream_flush(stream);
+    }
+    if (stream->map) {
+        munmap(stream->map, stream->map_size);
+    }
+    free(stream->buffer);
+    close(stream->fd);
+    free(stream);
+    parser->streams[id - 1] = NULL;
+    parser->stream_closes++;
+}
+
+void stream_close(Parser* parser, const char* handle) {
+    close_stream(parser, stream_id(handle));
+}
+
+void stream_close_all(Parser* parser) {
+    for (int i = 0; i < parser->stream_count; i++) {
+        close_stream(parser, i + 1);
+    }
+    parser->stream_count = 0;
+}
+
+// Lecture directe dans le buffer final : une seule copie depuis le noyau.
+char* stream_read_file(const char* path, size_t* length) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Erreur lors de l'ouverture du fichier");
+        return NULL;
+    }
+    
+    struct stat st;
+    size_t capacity = STREAM_BUFFER_SIZE;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        capacity = st.st_size + 1;
+    }
+    
+    char* content = malloc(capacity);
+    size_t size = 0;
+    while (1) {
+        if (size + 1 >= capacity) {
+            capacity *= 2;
+            content = realloc(content, capacity);
+        }
+        ssize_t count = read(fd, content + size, capacity - size - 1);
+        if (count <= 0) {
+            break;
+        }
+        size += count;
+    }
+    close(fd);
+    
+    content[size] = '\0';
+    if (length) {
+        *length = size;
+    }
+    return content;
+}
+
+int builtin_fopen(Parser* parser, int argc, Variable* args, Variable* result) {
+    if (argc < 1 || !args[0].value) {
+        return -1;
+    }
+    
+    int id = stream_open(parser, args[0].value, argc > 1 && args[1].value ? args[1].value : "r");
+    if (id) {
+        result->value = malloc(32);
+        snprintf(result->value, 32, HANDLE_PREFIX "%d", id);
+    }
+    return 0;
+}
+
+int builtin_fgets(Parser* parser, int argc, Variable* args, Variable* result) {
+    Stream* stream = argc > 0 ? stream_get(parser, args[0].value) : NULL;
+    if (!stream) {
+        return -1;
+    }
+    
+    const char* line;
+    size_t length;
+    if (stream_read_line(stream, &line, &length)) {
+        result->value = malloc(length + 1);
+        memcpy(result->value, line, length);
+        result->value[length] = '\0';
+    }
+    return 0;
+}
+
+int builtin_fwrite(Parser* parser, int argc, Variable* args, Variable* result) {
+    Stream* stream = argc > 1 ? stream_get(parser, args[0].value) : NULL;
+    if (!stream) {
+        return -1;
+    }
+    
+    size_t written = args[1].value ? stream_write(stream, args[1].value, strlen(args[1].value)) : 0;
+    result->value = malloc(32);
+    snprintf(result->value, 32, "%zu", written);
+    return 0;
+}
+
+int builtin_fclose(Parser* parser, int argc, Variable* args, Variable* result) {
+    if (argc < 1 || !stream_get(parser, args[0].value)) {
+        return -1;
+    }
+    
+    stream_close(parser, args[0].value);
+    result->value = strdup("1");
+    return 0;
+}
+
+int builtin_feof(Parser* parser, int argc, Variable* args, Variable* result) {
+    Stream* stream = argc > 0 ? stream_get(parser, args[0].value) : NULL;
+    if (!stream) {
+        return -1;
+    }
+    
+    int at_end = stream->map ? stream->start >= stream->map_size : 
+                               stream->eof && stream->start >= stream->end;
+    if (at_end) {
+        result->value = strdup("1");
+    }
+    return 0;
+}
+
+int builtin_file_get_contents(Parser* parser, int argc, Variable* args, Variable* result) {
+    (void)parser;
+    if (argc < 1 || !args[0].value) {
+        return -1;
+    }
+    
+    result->value = stream_read_file(args[0].value, NULL);
+    return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stddef.h>
+#include "parser.h"
+
+#define STREAM_BUFFER_SIZE (1 << 20)
+
+typedef struct Stream {
+    int fd;
+    int writable;
+    char* map;            // Fichier entier en lecture (mmap), NULL sinon
+    size_t map_size;
+    char* buffer;         // Buffer de read() ou d'écriture
+    size_t buffer_capacity;
+    size_t start;         // Début des données non consommées
+    size_t end;           // Fin des données valides
+    int eof;
+} Stream;
+
+int stream_open(Parser* parser, const char* path, const char* mode);
+Stream* stream_get(Parser* parser, const char* handle);
+int stream_read_line(Stream* stream, const char** line, size_t* length);
+size_t stream_write(Stream* stream, const char* data, size_t length);
+void stream_close(Parser* parser, const char* handle);
+void stream_close_all(Parser* parser);
+char* stream_read_file(const char* path, size_t* length);
+
+int builtin_fopen(Parser* parser, int argc, Variable* args, Variable* result);
+int builtin_fgets(Parser* parser, int argc, Variable* args, Variable* result);
+int builtin_fwrite(Parser* parser, int argc, Variable* args, Variable* result);
+int builtin_fclose(Parser* parser, int argc, Variable* args, Variable* result);
+int builtin_feof(Parser* parser, int argc, Variable* args, Variable* result);
+int builtin_file_get_contents(Parser* parser, int argc, Variable* args, Variable* result);
+
+#endif